@@ -0,0 +1,356 @@
+#include "simplify.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+// Measures the engines on synthetic polylines of 10 points up to a maximum count, by powers of 10,
+// and writes one CSV line per engine, dataset and size:
+//
+// engine,highest_quality,dataset,point_count,call_count,points_per_second,allocations_per_call,kept_ratio
+//
+// The datasets are random walks, sinusoids, GPS-like jittered tracks, spirals and straight lines,
+// generated from a fixed seed so that runs can be compared. Integer engines get the datasets scaled
+// to a 4096 extent, as tile coordinates.
+//
+// usage: benchmark [-n max_point_count] [-e tolerance] [-s min_seconds] [output]
+
+namespace
+{
+    std::atomic< std::size_t > allocation_count( 0 );
+}
+
+void * operator new( std::size_t size )
+{
+    ++allocation_count;
+
+    if ( void * pointer = std::malloc( size ? size : 1 ) )
+    {
+        return pointer;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete( void * pointer ) noexcept
+{
+    std::free( pointer );
+}
+
+#if defined( __cpp_sized_deallocation )
+
+void operator delete( void * pointer, std::size_t ) noexcept
+{
+    std::free( pointer );
+}
+
+#endif
+
+namespace
+{
+    struct options
+    {
+        std::size_t max_point_count { 1000000 };
+        double tolerance { 1.0 };
+        double min_seconds { 0.2 };
+        const char * output_path { nullptr };
+    };
+
+    // Points are generated in 3D, the 2D engines using their first two coordinates.
+
+    struct dataset
+    {
+        const char * name;
+        std::vector< double > coordinates;
+    };
+
+    std::vector< dataset > generate_datasets( const std::size_t point_count )
+    {
+        std::mt19937 generator( 42 );
+        std::normal_distribution< double > normal( 0.0, 1.0 );
+        std::vector< dataset > dataset_table {
+            { "random_walk", {} },
+            { "sinusoid", {} },
+            { "gps_track", {} },
+            { "spiral", {} },
+            { "straight_line", {} }
+            };
+
+        for ( auto & current : dataset_table )
+        {
+            current.coordinates.reserve( point_count * 3 );
+        }
+
+        double walk[ 3 ] { 0.0, 0.0, 0.0 }, track[ 3 ] { 0.0, 0.0, 0.0 }, heading = 0.0;
+
+        for ( std::size_t i = 0; i < point_count; ++i )
+        {
+            const double index = double( i );
+
+            for ( double & coordinate : walk )
+            {
+                coordinate += normal( generator );
+            }
+
+            // A vehicle at about 5 units per sample, turning smoothly, seen through 0.5 unit jitter.
+
+            heading += 0.05 * normal( generator );
+            track[ 0 ] += 5.0 * std::cos( heading );
+            track[ 1 ] += 5.0 * std::sin( heading );
+            track[ 2 ] = 20.0 * std::sin( index * 0.001 );
+
+            const double sinusoid[ 3 ] { index * 0.1, 10.0 * std::sin( index * 0.01 ), 5.0 * std::cos( index * 0.013 ) };
+            const double spiral[ 3 ] { index * 0.01 * std::cos( index * 0.01 ), index * 0.01 * std::sin( index * 0.01 ), index * 0.001 };
+            const double line[ 3 ] { index, 2.0 * index, 3.0 * index };
+            const double jittered_track[ 3 ] { track[ 0 ] + 0.5 * normal( generator ), track[ 1 ] + 0.5 * normal( generator ), track[ 2 ] };
+
+            dataset_table[ 0 ].coordinates.insert( dataset_table[ 0 ].coordinates.end(), walk, walk + 3 );
+            dataset_table[ 1 ].coordinates.insert( dataset_table[ 1 ].coordinates.end(), sinusoid, sinusoid + 3 );
+            dataset_table[ 2 ].coordinates.insert( dataset_table[ 2 ].coordinates.end(), jittered_track, jittered_track + 3 );
+            dataset_table[ 3 ].coordinates.insert( dataset_table[ 3 ].coordinates.end(), spiral, spiral + 3 );
+            dataset_table[ 4 ].coordinates.insert( dataset_table[ 4 ].coordinates.end(), line, line + 3 );
+        }
+
+        return dataset_table;
+    }
+
+    template< class T >
+    std::vector< T > convert( const std::vector< double > & coordinates, const std::size_t dimension )
+    {
+        const std::size_t point_count = coordinates.size() / 3;
+        std::vector< T > result( point_count * dimension );
+        double minimum[ 3 ] { 0.0, 0.0, 0.0 }, scale = 1.0;
+
+        if ( std::is_integral< T >::value && point_count )
+        {
+            double maximum_extent = 0.0;
+
+            for ( std::size_t j = 0; j < dimension; ++j )
+            {
+                double maximum = coordinates[ j ];
+
+                minimum[ j ] = coordinates[ j ];
+
+                for ( std::size_t i = 1; i < point_count; ++i )
+                {
+                    minimum[ j ] = std::min( minimum[ j ], coordinates[ i * 3 + j ] );
+                    maximum = std::max( maximum, coordinates[ i * 3 + j ] );
+                }
+
+                maximum_extent = std::max( maximum_extent, maximum - minimum[ j ] );
+            }
+
+            scale = maximum_extent > 0.0 ? 4095.0 / maximum_extent : 1.0;
+        }
+
+        for ( std::size_t i = 0; i < point_count; ++i )
+        {
+            for ( std::size_t j = 0; j < dimension; ++j )
+            {
+                const double value = ( coordinates[ i * 3 + j ] - minimum[ j ] ) * scale;
+
+                result[ i * dimension + j ] = std::is_integral< T >::value ? T( std::lround( value ) ) : T( value );
+            }
+        }
+
+        return result;
+    }
+
+    // Simplifies copies of input until min_seconds of calls were timed. Small polylines are
+    // simplified in batches of copies, so that the clock is not read around each short call.
+
+    template< class T, class Simplify >
+    void measure(
+        const options & opts,
+        std::FILE * output,
+        const char * engine,
+        const bool highest_quality,
+        const char * dataset_name,
+        const std::vector< T > & input,
+        const std::size_t dimension,
+        Simplify simplify
+        )
+    {
+        const std::size_t point_count = input.size() / dimension;
+        const std::size_t batch_size = std::max< std::size_t >( 1, ( std::size_t( 1 ) << 16 ) / point_count );
+        std::vector< T > work( batch_size * input.size() );
+        std::size_t call_count = 0, call_allocation_count = 0, kept_count = 0;
+        double seconds = 0.0;
+
+        while ( seconds < opts.min_seconds )
+        {
+            for ( std::size_t batch = 0; batch < batch_size; ++batch )
+            {
+                std::copy( input.begin(), input.end(), work.begin() + batch * input.size() );
+            }
+
+            const std::size_t first_allocation_count = allocation_count;
+            const auto start = std::chrono::steady_clock::now();
+
+            kept_count = 0;
+
+            for ( std::size_t batch = 0; batch < batch_size; ++batch )
+            {
+                T * first = work.data() + batch * input.size();
+
+                kept_count += static_cast< std::size_t >( simplify( first, first + input.size() ) - first ) / dimension;
+            }
+
+            seconds += std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+            call_allocation_count += allocation_count - first_allocation_count;
+            call_count += batch_size;
+        }
+
+        std::fprintf(
+            output,
+            "%s,%d,%s,%zu,%zu,%.0f,%.2f,%.4f\n",
+            engine,
+            int( highest_quality ),
+            dataset_name,
+            point_count,
+            call_count,
+            double( call_count ) * point_count / seconds,
+            double( call_allocation_count ) / call_count,
+            double( kept_count ) / ( double( batch_size ) * point_count )
+            );
+        std::fflush( output );
+    }
+
+    template< class T, std::size_t dimension >
+    void measure_helpers(
+        const options & opts,
+        std::FILE * output,
+        const char * engine,
+        const dataset & current
+        )
+    {
+        const std::vector< T > input = convert< T >( current.coordinates, dimension );
+        const T tolerance = static_cast< T >( std::is_integral< T >::value ? std::max( 1.0, std::round( opts.tolerance ) ) : opts.tolerance );
+
+        for ( bool highest_quality : { false, true } )
+        {
+            measure( opts, output, engine, highest_quality, current.name, input, dimension, [ & ]( T * first, T * last )
+            {
+                return ::simplify::helpers::simplify< T, dimension >( first, last, tolerance, highest_quality );
+            } );
+        }
+    }
+
+    void measure_dataset(
+        const options & opts,
+        std::FILE * output,
+        const dataset & current
+        )
+    {
+        typedef ::simplify::helpers::vect< double, 2 > vec;
+
+        const std::vector< double > input = convert< double >( current.coordinates, 2 );
+        const double tolerance = opts.tolerance;
+        auto get_point_point_square_distance = &::simplify::helpers::get_point_point_square_distance< double, vec >;
+        auto get_point_segment_square_distance = &::simplify::helpers::get_point_segment_square_distance< double, vec >;
+
+        measure( opts, output, "simplify_radial_distance", false, current.name, input, 2, [ & ]( double * first, double * last )
+        {
+            return reinterpret_cast< double * >( ::simplify::simplify_radial_distance( reinterpret_cast< vec * >( first ), reinterpret_cast< vec * >( last ), tolerance, get_point_point_square_distance ) );
+        } );
+
+        measure( opts, output, "simplify_douglas_peucker", true, current.name, input, 2, [ & ]( double * first, double * last )
+        {
+            return reinterpret_cast< double * >( ::simplify::simplify_douglas_peucker( reinterpret_cast< vec * >( first ), reinterpret_cast< vec * >( last ), tolerance, get_point_segment_square_distance ) );
+        } );
+
+        measure( opts, output, "simplify", false, current.name, input, 2, [ & ]( double * first, double * last )
+        {
+            return reinterpret_cast< double * >( ::simplify::simplify( reinterpret_cast< vec * >( first ), reinterpret_cast< vec * >( last ), tolerance, get_point_segment_square_distance, get_point_point_square_distance ) );
+        } );
+
+        measure_helpers< std::int16_t, 2 >( opts, output, "simplify2s", current );
+        measure_helpers< int, 2 >( opts, output, "simplify2i", current );
+        measure_helpers< int, 3 >( opts, output, "simplify3i", current );
+        measure_helpers< float, 2 >( opts, output, "simplify2f", current );
+        measure_helpers< float, 3 >( opts, output, "simplify3f", current );
+        measure_helpers< double, 2 >( opts, output, "simplify2d", current );
+        measure_helpers< double, 3 >( opts, output, "simplify3d", current );
+    }
+
+    int usage()
+    {
+        std::fprintf( stderr, "usage: benchmark [-n max_point_count] [-e tolerance] [-s min_seconds] [output]\n" );
+
+        return EXIT_FAILURE;
+    }
+}
+
+int main( int argc, char ** argv )
+{
+    options opts;
+    int argument_index = 1;
+
+    for ( ; argument_index + 1 < argc && argv[ argument_index ][ 0 ] == '-'; argument_index += 2 )
+    {
+        const std::string flag = argv[ argument_index ];
+        const char * value = argv[ argument_index + 1 ];
+
+        if ( flag == "-n" )
+        {
+            opts.max_point_count = std::strtoull( value, nullptr, 10 );
+        }
+        else if ( flag == "-e" )
+        {
+            opts.tolerance = std::strtod( value, nullptr );
+        }
+        else if ( flag == "-s" )
+        {
+            opts.min_seconds = std::strtod( value, nullptr );
+        }
+        else
+        {
+            return usage();
+        }
+    }
+
+    if ( argc - argument_index > 1 || ( argument_index < argc && argv[ argument_index ][ 0 ] == '-' && argv[ argument_index ][ 1 ] ) )
+    {
+        return usage();
+    }
+
+    opts.output_path = argument_index < argc ? argv[ argument_index ] : nullptr;
+
+    std::FILE * output = opts.output_path && std::strcmp( opts.output_path, "-" ) != 0 ? std::fopen( opts.output_path, "w" ) : stdout;
+
+    if ( !output )
+    {
+        std::fprintf( stderr, "benchmark: cannot open %s: %s\n", opts.output_path, std::strerror( errno ) );
+
+        return EXIT_FAILURE;
+    }
+
+    std::fprintf( output, "engine,highest_quality,dataset,point_count,call_count,points_per_second,allocations_per_call,kept_ratio\n" );
+
+    for ( std::size_t point_count = 10; point_count <= opts.max_point_count; point_count *= 10 )
+    {
+        for ( const dataset & current : generate_datasets( point_count ) )
+        {
+            std::fprintf( stderr, "%s, %zu points\n", current.name, point_count );
+            measure_dataset( opts, output, current );
+        }
+    }
+
+    if ( output != stdout && std::fclose( output ) != 0 )
+    {
+        std::fprintf( stderr, "benchmark: write failed: %s\n", std::strerror( errno ) );
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
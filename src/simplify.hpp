@@ -1,18 +1,85 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <iterator>
+#include <limits>
 #include <stack>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
+// Functions marked SIMPLIFY_CONSTEXPR14 can be evaluated in constant expressions from C++14 on.
+
+#if defined( __cpp_constexpr ) && __cpp_constexpr >= 201304
+    #define SIMPLIFY_CONSTEXPR14 constexpr
+#else
+    #define SIMPLIFY_CONSTEXPR14
+#endif
+
+// Functions marked SIMPLIFY_NOINLINE are rare fallbacks kept out of the hot loops that call them.
+
+#if defined( __GNUC__ )
+    #define SIMPLIFY_NOINLINE __attribute__( ( noinline ) )
+#elif defined( _MSC_VER )
+    #define SIMPLIFY_NOINLINE __declspec( noinline )
+#else
+    #define SIMPLIFY_NOINLINE
+#endif
+
 namespace simplify
 {
-    template< class ForwardIt, class T, class GetPointPointSquareDistance >
-    ForwardIt simplify_radial_distance(
+    // Whether [first, last) holds more than two items, without walking a forward range to its end.
+
+    template< class ForwardIt >
+    SIMPLIFY_CONSTEXPR14 bool has_more_than_two_items(
+        ForwardIt first,
+        ForwardIt last
+        )
+    {
+        return first != last && ++first != last && ++first != last;
+    }
+
+    // Statistics policies, which the engines notify as they go. no_statistics, the default, does
+    // nothing and is compiled out. simplify_statistics accumulates counters over calls, for instance
+    // to find the features hitting the quadratic Douglas-Peucker behaviour.
+
+    struct no_statistics
+    {
+        SIMPLIFY_CONSTEXPR14 void add_metric_evaluation_count( std::size_t ) {}
+        SIMPLIFY_CONSTEXPR14 void add_radial_kept_count( std::size_t ) {}
+        SIMPLIFY_CONSTEXPR14 void add_split() {}
+        SIMPLIFY_CONSTEXPR14 void update_range_depth( std::size_t ) {}
+        SIMPLIFY_CONSTEXPR14 void update_scratch_byte_count( std::size_t ) {}
+    };
+
+    struct simplify_statistics
+    {
+        SIMPLIFY_CONSTEXPR14 void add_metric_evaluation_count( std::size_t count ) { metric_evaluation_count += count; }
+        SIMPLIFY_CONSTEXPR14 void add_radial_kept_count( std::size_t count ) { radial_kept_count += count; }
+        SIMPLIFY_CONSTEXPR14 void add_split() { ++split_count; }
+        SIMPLIFY_CONSTEXPR14 void update_range_depth( std::size_t depth ) { maximum_range_depth = depth > maximum_range_depth ? depth : maximum_range_depth; }
+        SIMPLIFY_CONSTEXPR14 void update_scratch_byte_count( std::size_t byte_count ) { maximum_scratch_byte_count = byte_count > maximum_scratch_byte_count ? byte_count : maximum_scratch_byte_count; }
+
+        std::size_t metric_evaluation_count = 0;
+        std::size_t radial_kept_count = 0;
+        std::size_t split_count = 0;
+        std::size_t maximum_range_depth = 0;
+        std::size_t maximum_scratch_byte_count = 0;
+    };
+
+    template< class ForwardIt, class T, class GetPointPointSquareDistance, class Statistics >
+    SIMPLIFY_CONSTEXPR14 ForwardIt simplify_radial_distance(
         ForwardIt first,
         ForwardIt last,
         T tolerance,
-        GetPointPointSquareDistance get_point_point_square_distance
+        GetPointPointSquareDistance get_point_point_square_distance,
+        Statistics & statistics
         )
     {
         typedef typename std::iterator_traits< ForwardIt >::reference VectorReference;
@@ -25,7 +92,7 @@ namespace simplify
             "get_point_point_square_distance return value must match tolerance type"
             );
 
-        if ( std::distance( first, last ) <= 2 )
+        if ( !has_more_than_two_items( first, last ) )
         {
             return last;
         }
@@ -40,10 +107,13 @@ namespace simplify
 
             for( ForwardIt it = first; it != last; ++it )
             {
+                statistics.add_metric_evaluation_count( 1 );
+
                 if ( !( get_point_point_square_distance( *it, *last_kept_it ) < square_tolerance ) )
                 {
                     *first++ = std::move( *it );
                     last_kept_it = it;
+                    statistics.add_radial_kept_count( 1 );
                 }
 
                 last_item_it = it;
@@ -52,297 +122,3254 @@ namespace simplify
             if ( last_kept_it != last_item_it )
             {
                 *first++ = std::move( *last_item_it );
+                statistics.add_radial_kept_count( 1 );
             }
         }
 
         return first;
     }
 
-    template< class Iterator >
-    Iterator get_last_included(
-        Iterator /*first*/,
-        Iterator last,
-        typename std::enable_if<
-            std::is_base_of< std::bidirectional_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category >::value
-            >::type * = 0
+    template< class ForwardIt, class T, class GetPointPointSquareDistance >
+    SIMPLIFY_CONSTEXPR14 ForwardIt simplify_radial_distance(
+        ForwardIt first,
+        ForwardIt last,
+        T tolerance,
+        GetPointPointSquareDistance get_point_point_square_distance
         )
     {
-        return --last;
+        no_statistics statistics {};
+
+        return simplify_radial_distance( first, last, tolerance, get_point_point_square_distance, statistics );
     }
 
-    template< class Iterator >
-    Iterator get_last_included(
-        Iterator first,
-        Iterator last,
-        typename std::enable_if<
-            !std::is_base_of< std::bidirectional_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category >::value
-            >::type * = 0
+    template< class InputIt, class OutputIt, class T, class GetPointPointSquareDistance >
+    OutputIt simplify_radial_distance_copy(
+        InputIt first,
+        InputIt last,
+        OutputIt d_first,
+        T tolerance,
+        GetPointPointSquareDistance get_point_point_square_distance
         )
     {
-        Iterator last_included;
+        typedef typename std::iterator_traits< InputIt >::value_type Vector;
 
-        for ( auto it = first; it != last; ++it )
+        static_assert(
+            std::is_same<
+                typename std::result_of< GetPointPointSquareDistance( const Vector &, const Vector & ) >::type,
+                T
+                >::value,
+            "get_point_point_square_distance return value must match tolerance type"
+            );
+
+        // Single pass: the input is never measured nor revisited, so the last kept and the last read
+        // points are held by value. Up to two points are always copied as is, as the ends are kept.
+
+        if ( first == last )
         {
-            last_included = it;
+            return d_first;
         }
 
-        return last_included;
+        T square_tolerance = tolerance * tolerance;
+        Vector last_kept = *first;
+
+        *d_first++ = last_kept;
+
+        if ( ++first == last )
+        {
+            return d_first;
+        }
+
+        Vector last_item;
+        bool last_item_is_kept = false;
+
+        for( ; first != last; ++first )
+        {
+            last_item = *first;
+            last_item_is_kept = !( get_point_point_square_distance( last_item, last_kept ) < square_tolerance );
+
+            if ( last_item_is_kept )
+            {
+                *d_first++ = last_item;
+                last_kept = std::move( last_item );
+            }
+        }
+
+        if ( !last_item_is_kept )
+        {
+            *d_first++ = std::move( last_item );
+        }
+
+        return d_first;
     }
 
-    template< class ForwardIt, class T, class GetPointSegmentSquareDistance >
-    ForwardIt simplify_douglas_peucker(
+    // Decimates points by snapping them to a grid of cells of size tolerance: a point is dropped when
+    // get_cell puts it in the same cell as the point preceding it in the input, both ends being kept.
+    // As each test only involves two input points, the input is split in chunks compacted on up to
+    // thread_count threads (0 for one per core), which are then gathered.
+
+    template< class ForwardIt, class T, class GetCell >
+    ForwardIt simplify_grid_snap(
         ForwardIt first,
         ForwardIt last,
         T tolerance,
-        GetPointSegmentSquareDistance get_point_segment_square_distance
+        GetCell get_cell,
+        std::size_t thread_count = 1
         )
     {
-        typedef typename std::iterator_traits< ForwardIt >::reference VectorReference;
+        typedef typename std::decay< decltype( get_cell( *first, tolerance ) ) >::type Cell;
 
-        static_assert(
-            std::is_same<
-                typename std::result_of< GetPointSegmentSquareDistance( VectorReference, VectorReference, VectorReference ) >::type,
-                T
-                >::value,
-            "get_point_segment_square_distance return value must match tolerance type"
-            );
+        const std::size_t point_count = std::distance( first, last );
+        const std::size_t minimum_chunk_size = 1 << 16;
 
-        if ( std::distance( first, last ) <= 2 )
+        if ( point_count <= 2 || !( tolerance > static_cast< T >( 0 ) ) )
         {
             return last;
         }
-        else
+
+        if ( thread_count == 0 )
         {
-            T square_tolerance = tolerance * tolerance;
+            thread_count = std::max( 1u, std::thread::hardware_concurrency() );
+        }
 
-            auto initial_range = std::make_pair( first, get_last_included( first, last ) );
-            std::stack< decltype( initial_range ) > range_to_process_table;
+        const std::size_t interior_count = point_count - 2;
+        const std::size_t chunk_count = std::max< std::size_t >( 1, std::min( thread_count, interior_count / minimum_chunk_size ) );
+        const std::size_t chunk_size = ( interior_count + chunk_count - 1 ) / chunk_count;
 
-            range_to_process_table.push( initial_range );
+        // A chunk start is overwritten by the compaction of the chunk before it, so the cells of the
+        // points preceding each chunk are taken first.
 
-            std::vector< ForwardIt > to_keep_table;
-            to_keep_table.push_back( initial_range.first );
+        std::vector< ForwardIt > chunk_first_table, chunk_last_table( chunk_count );
+        std::vector< Cell > previous_cell_table;
+        ForwardIt it = first;
 
-            while( !range_to_process_table.empty() )
-            {
-                auto range = range_to_process_table.top();
-                auto maximum = static_cast< T >( -1 );
-                ForwardIt current_maximum_it = range.first;
+        for ( std::size_t chunk = 0; chunk < chunk_count; ++chunk )
+        {
+            previous_cell_table.push_back( get_cell( *it, tolerance ) );
+            chunk_first_table.push_back( ++it );
+            std::advance( it, std::min( chunk_size, interior_count - chunk * chunk_size ) - 1 );
+        }
 
-                if ( to_keep_table.back() != range.first )
-                    to_keep_table.push_back( range.first );
+        const ForwardIt last_item_it = ++it;
 
-                range_to_process_table.pop();
+        auto compact_chunk = [ & ]( std::size_t chunk )
+        {
+            ForwardIt read_it = chunk_first_table[ chunk ], write_it = read_it;
+            const ForwardIt chunk_last = chunk + 1 < chunk_count ? chunk_first_table[ chunk + 1 ] : last_item_it;
+            Cell previous_cell = previous_cell_table[ chunk ];
 
-                for( ForwardIt it = ++current_maximum_it; it != range.second; ++ it )
-                {
-                    auto square_distance = get_point_segment_square_distance( *it, *range.first, *range.second );
+            for ( ; read_it != chunk_last; ++read_it )
+            {
+                Cell cell = get_cell( *read_it, tolerance );
 
-                    if ( square_distance > maximum )
+                if ( !( cell == previous_cell ) )
+                {
+                    if ( write_it != read_it )
                     {
-                        maximum = square_distance;
-                        current_maximum_it = it;
+                        *write_it = std::move( *read_it );
                     }
-                }
 
-                if ( maximum >= square_tolerance )
-                {
-                    range_to_process_table.push( std::make_pair( current_maximum_it, range.second ) );
-                    range_to_process_table.push( std::make_pair( range.first, current_maximum_it ) );
+                    ++write_it;
                 }
+
+                previous_cell = std::move( cell );
             }
 
-            to_keep_table.push_back( initial_range.second );
+            chunk_last_table[ chunk ] = write_it;
+        };
 
-            for( auto it = to_keep_table.begin(); it != to_keep_table.end(); ++it )
-            {
-                *first++ = std::move( **it );
-            }
+        std::vector< std::thread > thread_table;
 
-            return first;
+        for ( std::size_t chunk = 1; chunk < chunk_count; ++chunk )
+        {
+            thread_table.emplace_back( compact_chunk, chunk );
+        }
+
+        compact_chunk( 0 );
+
+        for ( auto & thread : thread_table )
+        {
+            thread.join();
         }
+
+        ForwardIt write_it = chunk_last_table[ 0 ];
+
+        for ( std::size_t chunk = 1; chunk < chunk_count; ++chunk )
+        {
+            write_it = std::move( chunk_first_table[ chunk ], chunk_last_table[ chunk ], write_it );
+        }
+
+        if ( write_it != last_item_it )
+        {
+            *write_it = std::move( *last_item_it );
+        }
+
+        return ++write_it;
     }
 
-    template< class ForwardIt, class T, class GetPointSegmentSquareDistance >
-    ForwardIt simplify(
-        ForwardIt first,
-        ForwardIt last,
-        T tolerance,
-        GetPointSegmentSquareDistance get_point_segment_square_distance
+    template< class Iterator >
+    SIMPLIFY_CONSTEXPR14 Iterator get_last_included(
+        Iterator /*first*/,
+        Iterator last,
+        typename std::enable_if<
+            std::is_base_of< std::bidirectional_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category >::value
+            >::type * = 0
         )
     {
-        return simplify_douglas_peucker( first, last, tolerance, get_point_segment_square_distance );
+        return --last;
     }
 
-    template< class ForwardIt, class T, class GetPointSegmentSquareDistance, class GetPointPointSquareDistance >
-    ForwardIt simplify(
-        ForwardIt first,
-        ForwardIt last,
-        T tolerance,
-        GetPointSegmentSquareDistance get_point_segment_square_distance,
-        GetPointPointSquareDistance get_point_point_square_distance
+    template< class Iterator >
+    SIMPLIFY_CONSTEXPR14 Iterator get_last_included(
+        Iterator first,
+        Iterator last,
+        typename std::enable_if<
+            !std::is_base_of< std::bidirectional_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category >::value
+            >::type * = 0
         )
     {
-        last = simplify_radial_distance( first, last, tolerance, get_point_point_square_distance );
+        Iterator last_included = first;
 
-        return simplify_douglas_peucker( first, last, tolerance, get_point_segment_square_distance );
+        for ( auto it = first; it != last; ++it )
+        {
+            last_included = it;
+        }
+
+        return last_included;
     }
 
-    namespace helpers
+    // Index of it from first, constant time for random access iterators.
+
+    template< class Iterator >
+    SIMPLIFY_CONSTEXPR14 std::size_t get_index(
+        Iterator first,
+        Iterator it,
+        typename std::enable_if<
+            std::is_base_of< std::random_access_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category >::value
+            >::type * = 0
+        )
     {
-        template< class T, std::size_t dimension >
-        struct vect
-        {
-            T values[ dimension ];
-        };
+        return static_cast< std::size_t >( it - first );
+    }
 
-        template< class T, std::size_t dimension >
-        bool operator==(
-            const vect< T, dimension > & first,
-            const vect< T, dimension > & second
-            )
-        {
-            for ( std::size_t i = 0; i < dimension; ++i )
-            {
-                if ( first.values[ i ] != second.values[ i ] )
-                {
-                    return false;
-                }
-            }
+    template< class Iterator >
+    SIMPLIFY_CONSTEXPR14 std::size_t get_index(
+        Iterator first,
+        Iterator it,
+        typename std::enable_if<
+            !std::is_base_of< std::random_access_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category >::value
+            >::type * = 0
+        )
+    {
+        std::size_t index = 0;
 
-            return true;
+        for ( ; first != it; ++first )
+        {
+            ++index;
         }
 
-        template< class T, std::size_t dimension >
-        vect< T, dimension > operator-(
-            const vect< T, dimension > & first,
-            const vect< T, dimension > & second
-            )
-        {
-            vect< T, dimension > result;
+        return index;
+    }
 
-            for ( std::size_t i = 0; i < dimension; ++i )
-            {
-                result.values[ i ] = first.values[ i ] - second.values[ i ];
-            }
+    // Observers of the ranges of simplify_douglas_peucker, called as observer( first_index,
+    // last_index, split_index, maximum, is_split ) for each range popped: its ends as indices in
+    // the polyline, the farthest point and its squared distance, and whether the range is split
+    // there. A range without interior point reports last_index as split and -1 as distance.
+    // no_douglas_peucker_observer, the default, does nothing and no index is computed for it; other
+    // observers walk non-random-access ranges to get the indices.
 
-            return result;
-        }
+    struct no_douglas_peucker_observer
+    {
+        template< class Distance >
+        SIMPLIFY_CONSTEXPR14 void operator()( std::size_t, std::size_t, std::size_t, const Distance &, bool ) const {}
+    };
 
-        template< class T, std::size_t dimension >
-        T dot(
-            const vect< T, dimension > & first,
-            const vect< T, dimension > & second
-            )
-        {
-            auto result = static_cast< T >( 0 );
+    // Calls observer with the indices of the range and of its farthest point. The overload for
+    // no_douglas_peucker_observer does not compute them, as get_index walks the polyline for
+    // non-random-access iterators.
 
-            // :TODO: check valid range for T
+    template< class ForwardIt, class Distance >
+    SIMPLIFY_CONSTEXPR14 void notify_douglas_peucker_observer(
+        no_douglas_peucker_observer &,
+        ForwardIt,
+        ForwardIt,
+        ForwardIt,
+        ForwardIt,
+        const Distance &,
+        bool
+        )
+    {
+    }
 
-            for ( std::size_t i = 0; i < dimension; ++i )
-            {
-                result += first.values[ i ] * second.values[ i ];
-            }
+    template< class Observer, class ForwardIt, class Distance >
+    SIMPLIFY_CONSTEXPR14 void notify_douglas_peucker_observer(
+        Observer & observer,
+        ForwardIt first,
+        ForwardIt range_first,
+        ForwardIt range_last,
+        ForwardIt split_it,
+        const Distance & maximum,
+        bool is_split
+        )
+    {
+        observer( get_index( first, range_first ), get_index( first, range_last ), get_index( first, split_it ), maximum, is_split );
+    }
 
-            return result;
-        }
+    // Work tables of simplify_douglas_peucker. Passing the same instance to successive calls reuses
+    // their storage instead of allocating it again for each polyline. The engines also notify the
+    // statistics policy through it, see no_statistics.
 
-        template< class T, class P, std::size_t dimension >
-        vect< T, dimension > lerp(
-            const vect< T, dimension > & first,
-            const vect< T, dimension > & second,
-            const P interpolation_parameter
-            )
+    template< class ForwardIt, class Statistics = no_statistics >
+    struct douglas_peucker_scratch
+    {
+        typedef std::pair< ForwardIt, ForwardIt > range;
+
+        std::stack< range, std::vector< range > > range_to_process_table;
+        std::vector< ForwardIt > to_keep_table;
+        Statistics statistics;
+    };
+
+    // Fixed-capacity work tables, with the interface of douglas_peucker_scratch used by the engines.
+    // They need no allocation, so simplification can run in constant expressions. capacity must be
+    // at least the number of points simplified.
+
+    template< class ForwardIt, std::size_t capacity, class Statistics = no_statistics >
+    struct fixed_douglas_peucker_scratch
+    {
+        struct range
         {
-            auto result = first;
+            ForwardIt first, second;
+        };
 
-            for ( std::size_t i = 0; i < dimension; ++i )
-            {
-                result.values[ i ] += T( interpolation_parameter * ( second.values[ i ] - first.values[ i ] ) );
-            }
+        struct range_stack
+        {
+            SIMPLIFY_CONSTEXPR14 bool empty() const { return item_count == 0; }
+            SIMPLIFY_CONSTEXPR14 std::size_t size() const { return item_count; }
+            SIMPLIFY_CONSTEXPR14 const range & top() const { return table[ item_count - 1 ]; }
+            SIMPLIFY_CONSTEXPR14 void push( const std::pair< ForwardIt, ForwardIt > & value ) { table[ item_count++ ] = range { value.first, value.second }; }
+            SIMPLIFY_CONSTEXPR14 void pop() { --item_count; }
 
-            return result;
-        }
+            range table[ capacity ] {};
+            std::size_t item_count = 0;
+        };
 
-        template< class T, class V >
-        T get_point_point_square_distance(
-            const V & first,
-            const V & second
-            )
+        struct iterator_table
         {
-            auto diff = second - first;
+            SIMPLIFY_CONSTEXPR14 std::size_t size() const { return item_count; }
+            SIMPLIFY_CONSTEXPR14 void clear() { item_count = 0; }
+            SIMPLIFY_CONSTEXPR14 void push_back( const ForwardIt value ) { table[ item_count++ ] = value; }
+            SIMPLIFY_CONSTEXPR14 const ForwardIt & back() const { return table[ item_count - 1 ]; }
+            SIMPLIFY_CONSTEXPR14 const ForwardIt * begin() const { return table; }
+            SIMPLIFY_CONSTEXPR14 const ForwardIt * end() const { return table + item_count; }
 
-            return dot( diff, diff );
-        }
+            ForwardIt table[ capacity ] {};
+            std::size_t item_count = 0;
+        };
 
-        template< class T, class V >
-        T get_point_segment_square_distance(
-            const V & candidate,
-            const V & segment_start,
-            const V & segment_end
-            )
+        range_stack range_to_process_table;
+        iterator_table to_keep_table;
+        Statistics statistics;
+    };
+
+    // Splits the ranges left in scratch.range_to_process_table, then moves the kept points to the
+    // front of the input, first and last_included being the ends of the whole polyline.
+
+    template< class ForwardIt, class T, class GetPointSegmentSquareDistance, class Scratch, class Observer = no_douglas_peucker_observer >
+    SIMPLIFY_CONSTEXPR14 ForwardIt process_douglas_peucker_ranges(
+        ForwardIt first,
+        ForwardIt last_included,
+        T square_tolerance,
+        GetPointSegmentSquareDistance get_point_segment_square_distance,
+        Scratch & scratch,
+        Observer observer = Observer()
+        )
+    {
+        auto & range_to_process_table = scratch.range_to_process_table;
+        auto & to_keep_table = scratch.to_keep_table;
+        std::size_t maximum_range_depth = range_to_process_table.size();
+
+        to_keep_table.clear();
+        to_keep_table.push_back( first );
+        scratch.statistics.update_range_depth( maximum_range_depth );
+
+        while( !range_to_process_table.empty() )
         {
-            const auto segment_square_length = get_point_point_square_distance< T >( segment_start, segment_end );
+            auto range = range_to_process_table.top();
+            auto maximum = static_cast< T >( -1 );
+            ForwardIt current_maximum_it = range.first;
 
-            // :TODO: use precision
+            if ( to_keep_table.back() != range.first )
+                to_keep_table.push_back( range.first );
 
-            if ( segment_square_length == static_cast< decltype( segment_square_length ) >( 0 ) )
+            range_to_process_table.pop();
+
+            for( ForwardIt it = ++current_maximum_it; it != range.second; ++ it )
             {
-                return get_point_point_square_distance< T >( candidate, segment_start );
-            }
+                auto square_distance = get_point_segment_square_distance( *it, *range.first, *range.second );
 
-            const double t = double( dot( candidate - segment_start, segment_end - segment_start ) ) / segment_square_length;
+                scratch.statistics.add_metric_evaluation_count( 1 );
+
+                if ( square_distance > maximum )
+                {
+                    maximum = square_distance;
+                    current_maximum_it = it;
+                }
+            }
+
+            notify_douglas_peucker_observer( observer, first, range.first, range.second, current_maximum_it, maximum, maximum >= square_tolerance );
+
+            if ( maximum >= square_tolerance )
+            {
+                range_to_process_table.push( std::make_pair( current_maximum_it, range.second ) );
+                range_to_process_table.push( std::make_pair( range.first, current_maximum_it ) );
+                maximum_range_depth = range_to_process_table.size() > maximum_range_depth ? range_to_process_table.size() : maximum_range_depth;
+                scratch.statistics.add_split();
+                scratch.statistics.update_range_depth( range_to_process_table.size() );
+            }
+        }
+
+        to_keep_table.push_back( last_included );
+        scratch.statistics.update_scratch_byte_count( maximum_range_depth * sizeof( range_to_process_table.top() ) + to_keep_table.size() * sizeof( ForwardIt ) );
+
+        for( auto it = to_keep_table.begin(); it != to_keep_table.end(); ++it )
+        {
+            *first++ = std::move( **it );
+        }
+
+        return first;
+    }
+
+    template< class ForwardIt, class T, class GetPointSegmentSquareDistance, class Scratch, class Observer = no_douglas_peucker_observer >
+    SIMPLIFY_CONSTEXPR14 ForwardIt simplify_douglas_peucker(
+        ForwardIt first,
+        ForwardIt last,
+        T tolerance,
+        GetPointSegmentSquareDistance get_point_segment_square_distance,
+        Scratch & scratch,
+        Observer observer = Observer()
+        )
+    {
+        typedef typename std::iterator_traits< ForwardIt >::reference VectorReference;
+
+        static_assert(
+            std::is_same<
+                typename std::result_of< GetPointSegmentSquareDistance( VectorReference, VectorReference, VectorReference ) >::type,
+                T
+                >::value,
+            "get_point_segment_square_distance return value must match tolerance type"
+            );
+
+        if ( !has_more_than_two_items( first, last ) )
+        {
+            return last;
+        }
+        else
+        {
+            auto & range_to_process_table = scratch.range_to_process_table;
+            const ForwardIt last_included = get_last_included( first, last );
+
+            range_to_process_table.push( std::make_pair( first, last_included ) );
+
+            return process_douglas_peucker_ranges( first, last_included, tolerance * tolerance, get_point_segment_square_distance, scratch, observer );
+        }
+    }
+
+    template< class ForwardIt, class T, class GetPointSegmentSquareDistance >
+    ForwardIt simplify_douglas_peucker(
+        ForwardIt first,
+        ForwardIt last,
+        T tolerance,
+        GetPointSegmentSquareDistance get_point_segment_square_distance
+        )
+    {
+        douglas_peucker_scratch< ForwardIt > scratch;
+
+        return simplify_douglas_peucker( first, last, tolerance, get_point_segment_square_distance, scratch );
+    }
+
+    // Same result as simplify_radial_distance followed by simplify_douglas_peucker, in one pass less:
+    // the top-level segment joins the first and last points, which the radial pass always keeps, so
+    // the farthest radial survivor is found while the survivors are written.
+
+    template< class ForwardIt, class T, class GetPointSegmentSquareDistance, class GetPointPointSquareDistance, class Scratch >
+    SIMPLIFY_CONSTEXPR14 ForwardIt simplify_radial_douglas_peucker(
+        ForwardIt first,
+        ForwardIt last,
+        T tolerance,
+        GetPointSegmentSquareDistance get_point_segment_square_distance,
+        GetPointPointSquareDistance get_point_point_square_distance,
+        Scratch & scratch
+        )
+    {
+        typedef typename std::iterator_traits< ForwardIt >::reference VectorReference;
+        typedef typename std::iterator_traits< ForwardIt >::value_type Vector;
+
+        static_assert(
+            std::is_same<
+                typename std::result_of< GetPointPointSquareDistance( VectorReference, VectorReference ) >::type,
+                T
+                >::value,
+            "get_point_point_square_distance return value must match tolerance type"
+            );
+
+        static_assert(
+            std::is_same<
+                typename std::result_of< GetPointSegmentSquareDistance( VectorReference, VectorReference, VectorReference ) >::type,
+                T
+                >::value,
+            "get_point_segment_square_distance return value must match tolerance type"
+            );
+
+        if ( !has_more_than_two_items( first, last ) )
+        {
+            return last;
+        }
+
+        // The last point may be overwritten by the survivors before the scan ends, so it is copied.
+        // The copy is not const, so that it binds to VectorReference like the other arguments.
+
+        T square_tolerance = tolerance * tolerance;
+        const ForwardIt last_item_it = get_last_included( first, last );
+        Vector segment_end = *last_item_it;
+        ForwardIt last_kept_it = first, write_it = first, last_written_it = first, maximum_it = first;
+        auto maximum = static_cast< T >( -1 );
+
+        for( ForwardIt it = ++write_it; it != last; ++it )
+        {
+            scratch.statistics.add_metric_evaluation_count( 1 );
+
+            if ( !( get_point_point_square_distance( *it, *last_kept_it ) < square_tolerance ) )
+            {
+                scratch.statistics.add_radial_kept_count( 1 );
+
+                if ( it != last_item_it )
+                {
+                    auto square_distance = get_point_segment_square_distance( *it, *first, segment_end );
+
+                    scratch.statistics.add_metric_evaluation_count( 1 );
+
+                    if ( square_distance > maximum )
+                    {
+                        maximum = square_distance;
+                        maximum_it = write_it;
+                    }
+                }
+
+                last_written_it = write_it;
+                *write_it++ = std::move( *it );
+                last_kept_it = it;
+            }
+        }
+
+        if ( last_kept_it != last_item_it )
+        {
+            last_written_it = write_it;
+            *write_it = std::move( *last_item_it );
+            scratch.statistics.add_radial_kept_count( 1 );
+        }
+
+        if ( maximum >= square_tolerance )
+        {
+            scratch.range_to_process_table.push( std::make_pair( maximum_it, last_written_it ) );
+            scratch.range_to_process_table.push( std::make_pair( first, maximum_it ) );
+            scratch.statistics.add_split();
+        }
+
+        return process_douglas_peucker_ranges( first, last_written_it, square_tolerance, get_point_segment_square_distance, scratch );
+    }
+
+    // Runs the Douglas-Peucker recursion once for a whole list of tolerances, sorted from the coarsest
+    // (largest) to the finest. Results are nested: levels receives, for each point, the index of the
+    // first tolerance at which simplify_douglas_peucker would keep it, or the tolerance count if it
+    // is never kept. Keeping the points whose level is <= l gives the result for tolerance l. The
+    // input is left untouched and levels must be random access. Returns the end of the written levels.
+
+    template< class ForwardIt, class TolerancesIt, class LevelIt, class GetPointSegmentSquareDistance >
+    LevelIt simplify_douglas_peucker_levels(
+        ForwardIt first,
+        ForwardIt last,
+        TolerancesIt tolerances_first,
+        TolerancesIt tolerances_last,
+        LevelIt levels,
+        GetPointSegmentSquareDistance get_point_segment_square_distance
+        )
+    {
+        typedef typename std::iterator_traits< ForwardIt >::reference VectorReference;
+        typedef typename std::iterator_traits< TolerancesIt >::value_type T;
+        typedef typename std::iterator_traits< LevelIt >::value_type Level;
+
+        static_assert(
+            std::is_same<
+                typename std::result_of< GetPointSegmentSquareDistance( VectorReference, VectorReference, VectorReference ) >::type,
+                T
+                >::value,
+            "get_point_segment_square_distance return value must match tolerance type"
+            );
+
+        struct range
+        {
+            ForwardIt first, second;
+            std::size_t first_index, second_index;
+            T importance;
+        };
+
+        std::vector< T > square_tolerance_table;
+
+        for ( auto it = tolerances_first; it != tolerances_last; ++it )
+        {
+            square_tolerance_table.push_back( *it * *it );
+        }
+
+        const Level level_count = static_cast< Level >( square_tolerance_table.size() );
+        const std::size_t point_count = std::distance( first, last );
+
+        if ( point_count <= 2 || square_tolerance_table.empty() )
+        {
+            std::fill( levels, levels + point_count, Level( 0 ) );
+
+            return levels + point_count;
+        }
+
+        std::fill( levels, levels + point_count, level_count );
+
+        // A point is kept at a tolerance only when its own split and all the enclosing ones reach it,
+        // so each range carries the smallest maximum found on the way down, capped to the coarsest
+        // tolerance for the initial range.
+
+        std::stack< range, std::vector< range > > range_to_process_table;
+        const range initial_range { first, get_last_included( first, last ), 0, point_count - 1, square_tolerance_table.front() };
+
+        levels[ 0 ] = levels[ point_count - 1 ] = Level( 0 );
+        range_to_process_table.push( initial_range );
+
+        while( !range_to_process_table.empty() )
+        {
+            const range current = range_to_process_table.top();
+            auto maximum = static_cast< T >( -1 );
+            ForwardIt current_maximum_it = current.first;
+            std::size_t current_maximum_index = current.first_index, index = current.first_index;
+
+            range_to_process_table.pop();
+
+            for( ForwardIt it = ++current_maximum_it; it != current.second; ++it )
+            {
+                auto square_distance = get_point_segment_square_distance( *it, *current.first, *current.second );
+
+                ++index;
+
+                if ( square_distance > maximum )
+                {
+                    maximum = square_distance;
+                    current_maximum_it = it;
+                    current_maximum_index = index;
+                }
+            }
+
+            if ( maximum >= square_tolerance_table.back() )
+            {
+                const T importance = std::min( maximum, current.importance );
+                Level level = 0;
+
+                while ( importance < square_tolerance_table[ level ] )
+                {
+                    ++level;
+                }
+
+                levels[ current_maximum_index ] = level;
+
+                range_to_process_table.push( range { current_maximum_it, current.second, current_maximum_index, current.second_index, importance } );
+                range_to_process_table.push( range { current.first, current_maximum_it, current.first_index, current_maximum_index, importance } );
+            }
+        }
+
+        return levels + point_count;
+    }
+
+    template< class ForwardIt, class T, class GetPointSegmentSquareDistance >
+    ForwardIt simplify(
+        ForwardIt first,
+        ForwardIt last,
+        T tolerance,
+        GetPointSegmentSquareDistance get_point_segment_square_distance
+        )
+    {
+        return simplify_douglas_peucker( first, last, tolerance, get_point_segment_square_distance );
+    }
+
+    template< class ForwardIt, class T, class GetPointSegmentSquareDistance, class GetPointPointSquareDistance >
+    ForwardIt simplify(
+        ForwardIt first,
+        ForwardIt last,
+        T tolerance,
+        GetPointSegmentSquareDistance get_point_segment_square_distance,
+        GetPointPointSquareDistance get_point_point_square_distance
+        )
+    {
+        douglas_peucker_scratch< ForwardIt > scratch;
+
+        return simplify_radial_douglas_peucker( first, last, tolerance, get_point_segment_square_distance, get_point_point_square_distance, scratch );
+    }
+
+    template< class GetCell >
+    struct grid_snap_filter
+    {
+        GetCell get_cell;
+        std::size_t thread_count;
+    };
+
+    // Selects simplify_grid_snap instead of simplify_radial_distance as the pre-pass of simplify.
+
+    template< class GetCell >
+    grid_snap_filter< GetCell > grid_snap(
+        GetCell get_cell,
+        std::size_t thread_count = 1
+        )
+    {
+        return grid_snap_filter< GetCell > { get_cell, thread_count };
+    }
+
+    template< class ForwardIt, class T, class GetPointSegmentSquareDistance, class GetCell >
+    ForwardIt simplify(
+        ForwardIt first,
+        ForwardIt last,
+        T tolerance,
+        GetPointSegmentSquareDistance get_point_segment_square_distance,
+        grid_snap_filter< GetCell > filter
+        )
+    {
+        last = simplify_grid_snap( first, last, tolerance, filter.get_cell, filter.thread_count );
+
+        return simplify_douglas_peucker( first, last, tolerance, get_point_segment_square_distance );
+    }
+
+    namespace helpers
+    {
+        template< class T, std::size_t dimension >
+        struct vect
+        {
+            T values[ dimension ];
+        };
+
+        // Per-coordinate loops unrolled at compile time: unrolled< 0, dimension > expands to
+        // straight-line code for any dimension, so the 2D and 3D paths have no loop left. Sums are
+        // accumulated in coordinate order, as a loop would, so results are unchanged. C++11
+        // constexpr functions are single expressions, hence the recursion instead of a loop.
+
+        template< std::size_t index, std::size_t dimension >
+        struct unrolled
+        {
+            typedef unrolled< index + 1, dimension > next;
+
+            template< class T >
+            static constexpr bool is_equal( const vect< T, dimension > & first, const vect< T, dimension > & second )
+            {
+                return first.values[ index ] == second.values[ index ] && next::is_equal( first, second );
+            }
+
+            template< class T >
+            static constexpr T dot( const vect< T, dimension > & first, const vect< T, dimension > & second, const T result )
+            {
+                return next::dot( first, second, T( result + first.values[ index ] * second.values[ index ] ) );
+            }
+
+            // Adds ( first - second ).( third - fourth ) to result, without building the differences.
+
+            template< class T >
+            static constexpr T difference_dot(
+                const vect< T, dimension > & first,
+                const vect< T, dimension > & second,
+                const vect< T, dimension > & third,
+                const vect< T, dimension > & fourth,
+                const T result
+                )
+            {
+                return next::difference_dot(
+                    first,
+                    second,
+                    third,
+                    fourth,
+                    T( result + T( first.values[ index ] - second.values[ index ] ) * T( third.values[ index ] - fourth.values[ index ] ) )
+                    );
+            }
+
+            // Adds the squared distance from candidate to lerp( segment_start, segment_end, t ) to
+            // result, rounding the projection to T as lerp does.
+
+            template< class T, class P >
+            static constexpr T lerp_square_distance(
+                const vect< T, dimension > & candidate,
+                const vect< T, dimension > & segment_start,
+                const vect< T, dimension > & segment_end,
+                const P t,
+                const T result
+                )
+            {
+                return next::lerp_square_distance(
+                    candidate,
+                    segment_start,
+                    segment_end,
+                    t,
+                    T( result + square( T( T( segment_start.values[ index ] + T( t * ( segment_end.values[ index ] - segment_start.values[ index ] ) ) ) - candidate.values[ index ] ) ) )
+                    );
+            }
+
+            // Adds |u - t v|^2 to result, with u = candidate - segment_start and
+            // v = segment_end - segment_start, everything computed in T.
+
+            template< class T >
+            static constexpr T residual_square_distance(
+                const vect< T, dimension > & candidate,
+                const vect< T, dimension > & segment_start,
+                const vect< T, dimension > & segment_end,
+                const T t,
+                const T result
+                )
+            {
+                return next::residual_square_distance(
+                    candidate,
+                    segment_start,
+                    segment_end,
+                    t,
+                    T( result + square( T( T( candidate.values[ index ] - segment_start.values[ index ] ) - t * T( segment_end.values[ index ] - segment_start.values[ index ] ) ) ) )
+                    );
+            }
+
+        private:
+
+            template< class T >
+            static constexpr T square( const T value )
+            {
+                return value * value;
+            }
+        };
+
+        template< std::size_t dimension >
+        struct unrolled< dimension, dimension >
+        {
+            template< class T >
+            static constexpr bool is_equal( const vect< T, dimension > &, const vect< T, dimension > & )
+            {
+                return true;
+            }
+
+            template< class T >
+            static constexpr T dot( const vect< T, dimension > &, const vect< T, dimension > &, const T result )
+            {
+                return result;
+            }
+
+            template< class T >
+            static constexpr T difference_dot( const vect< T, dimension > &, const vect< T, dimension > &, const vect< T, dimension > &, const vect< T, dimension > &, const T result )
+            {
+                return result;
+            }
+
+            template< class T, class P >
+            static constexpr T lerp_square_distance( const vect< T, dimension > &, const vect< T, dimension > &, const vect< T, dimension > &, const P, const T result )
+            {
+                return result;
+            }
+
+            template< class T >
+            static constexpr T residual_square_distance( const vect< T, dimension > &, const vect< T, dimension > &, const vect< T, dimension > &, const T, const T result )
+            {
+                return result;
+            }
+        };
+
+        // The same for the functions building a vect, which expand an index pack into its
+        // initializer instead.
+
+        template< std::size_t... index >
+        struct index_list
+        {
+        };
+
+        template< std::size_t count, std::size_t... index >
+        struct make_index_list : make_index_list< count - 1, count - 1, index... >
+        {
+        };
+
+        template< std::size_t... index >
+        struct make_index_list< 0, index... >
+        {
+            typedef index_list< index... > type;
+        };
+
+        template< class T, std::size_t dimension, std::size_t... index >
+        constexpr vect< T, dimension > subtract(
+            const vect< T, dimension > & first,
+            const vect< T, dimension > & second,
+            index_list< index... >
+            )
+        {
+            return vect< T, dimension > { { T( first.values[ index ] - second.values[ index ] )... } };
+        }
+
+        template< class T, class P, std::size_t dimension, std::size_t... index >
+        constexpr vect< T, dimension > lerp(
+            const vect< T, dimension > & first,
+            const vect< T, dimension > & second,
+            const P interpolation_parameter,
+            index_list< index... >
+            )
+        {
+            return vect< T, dimension > { { T( first.values[ index ] + T( interpolation_parameter * ( second.values[ index ] - first.values[ index ] ) ) )... } };
+        }
+
+        template< class U, class T, std::size_t dimension, std::size_t... index >
+        constexpr vect< U, dimension > vect_cast(
+            const vect< T, dimension > & value,
+            index_list< index... >
+            )
+        {
+            return vect< U, dimension > { { static_cast< U >( value.values[ index ] )... } };
+        }
+
+        template< class T, std::size_t dimension >
+        constexpr bool operator==(
+            const vect< T, dimension > & first,
+            const vect< T, dimension > & second
+            )
+        {
+            return unrolled< 0, dimension >::is_equal( first, second );
+        }
+
+        template< class T, std::size_t dimension >
+        constexpr vect< T, dimension > operator-(
+            const vect< T, dimension > & first,
+            const vect< T, dimension > & second
+            )
+        {
+            return subtract( first, second, typename make_index_list< dimension >::type() );
+        }
+
+        // Products and sums are taken in T, with no range check: an integral T overflows once the
+        // squared coordinates add up past its range. The exact integer kernel below works on 64-bit
+        // differences instead; get_point_segment_square_distance and the promoted kernel keep T, so
+        // with integers they need squared distances that fit in T.
+
+        template< class T, std::size_t dimension >
+        constexpr T dot(
+            const vect< T, dimension > & first,
+            const vect< T, dimension > & second
+            )
+        {
+            return unrolled< 0, dimension >::dot( first, second, static_cast< T >( 0 ) );
+        }
+
+        // dot( first - second, third - fourth ), without the temporaries.
+
+        template< class T, std::size_t dimension >
+        constexpr T difference_dot(
+            const vect< T, dimension > & first,
+            const vect< T, dimension > & second,
+            const vect< T, dimension > & third,
+            const vect< T, dimension > & fourth
+            )
+        {
+            return unrolled< 0, dimension >::difference_dot( first, second, third, fourth, static_cast< T >( 0 ) );
+        }
+
+        template< class T, class P, std::size_t dimension >
+        constexpr vect< T, dimension > lerp(
+            const vect< T, dimension > & first,
+            const vect< T, dimension > & second,
+            const P interpolation_parameter
+            )
+        {
+            return lerp( first, second, interpolation_parameter, typename make_index_list< dimension >::type() );
+        }
+
+        template< class U, class T, std::size_t dimension >
+        constexpr vect< U, dimension > vect_cast(
+            const vect< T, dimension > & value
+            )
+        {
+            return vect_cast< U >( value, typename make_index_list< dimension >::type() );
+        }
+
+        template< class T, class V >
+        constexpr T get_point_point_square_distance(
+            const V & first,
+            const V & second
+            )
+        {
+            return difference_dot( second, first, second, first );
+        }
+
+        // Squared distance from candidate to lerp( segment_start, segment_end, t ), without the
+        // temporary projection.
+
+        template< class T, class P, std::size_t dimension >
+        constexpr T lerp_square_distance(
+            const vect< T, dimension > & candidate,
+            const vect< T, dimension > & segment_start,
+            const vect< T, dimension > & segment_end,
+            const P t
+            )
+        {
+            return unrolled< 0, dimension >::lerp_square_distance( candidate, segment_start, segment_end, t, static_cast< T >( 0 ) );
+        }
+
+        template< class T, class V >
+        SIMPLIFY_CONSTEXPR14 T get_point_segment_square_distance(
+            const V & candidate,
+            const V & segment_start,
+            const V & segment_end
+            )
+        {
+            const auto segment_square_length = get_point_point_square_distance< T >( segment_start, segment_end );
+
+            // :TODO: use precision
+
+            if ( segment_square_length == static_cast< decltype( segment_square_length ) >( 0 ) )
+            {
+                return get_point_point_square_distance< T >( candidate, segment_start );
+            }
+
+            const double t = double( difference_dot( candidate, segment_start, segment_end, segment_start ) ) / segment_square_length;
 
             if ( t < 0.0 )
             {
-                return get_point_point_square_distance< T >( candidate, segment_start );
+                return get_point_point_square_distance< T >( candidate, segment_start );
+            }
+            else if ( t > 1.0 )
+            {
+                return get_point_point_square_distance< T >( candidate, segment_end );
+            }
+            else
+            {
+                return lerp_square_distance( candidate, segment_start, segment_end, t );
+            }
+        }
+
+        // Distance functions used by the engines of this namespace for vect< T, dimension >, along
+        // with the types they return and the squared tolerance they are compared to. This one uses
+        // get_point_segment_square_distance, which computes the projection parameter in double.
+
+        template< class T, std::size_t dimension >
+        struct promoted_distance_kernel
+        {
+            typedef vect< T, dimension > vec;
+            typedef T point_square_distance;
+            typedef T segment_square_distance;
+
+            static point_square_distance get_point_square_tolerance( const T tolerance )
+            {
+                return tolerance * tolerance;
+            }
+
+            static segment_square_distance get_segment_square_tolerance( const T tolerance )
+            {
+                return tolerance * tolerance;
+            }
+
+            static SIMPLIFY_CONSTEXPR14 point_square_distance get_point_point_square_distance( const vec & first, const vec & second )
+            {
+                return helpers::get_point_point_square_distance< T >( first, second );
+            }
+
+            static SIMPLIFY_CONSTEXPR14 segment_square_distance get_point_segment_square_distance( const vec & candidate, const vec & segment_start, const vec & segment_end )
+            {
+                return helpers::get_point_segment_square_distance< T >( candidate, segment_start, segment_end );
+            }
+        };
+
+        // Computes everything in T, without promotion, so that float code keeps float vector lanes.
+        // With u = candidate - segment_start and v = segment_end - segment_start, the candidate is
+        // measured against an end when u.v <= 0 or u.v >= |v|^2, and otherwise against
+        // u - ( u.v / |v|^2 ) v. Each of these is a handful of correctly rounded operations on values
+        // of the magnitude of |u| and |v|, so the result is within a few ulps of that magnitude
+        // squared: distances closer than that to the tolerance can be decided either way, where the
+        // promoted kernel would only decide them differently below double precision.
+
+        template< class T, std::size_t dimension >
+        struct native_distance_kernel : promoted_distance_kernel< T, dimension >
+        {
+            typedef vect< T, dimension > vec;
+
+            static SIMPLIFY_CONSTEXPR14 T get_point_segment_square_distance( const vec & candidate, const vec & segment_start, const vec & segment_end )
+            {
+                const T segment_square_length = difference_dot( segment_end, segment_start, segment_end, segment_start );
+                const T projection = difference_dot( candidate, segment_start, segment_end, segment_start );
+
+                if ( projection <= static_cast< T >( 0 ) || segment_square_length == static_cast< T >( 0 ) )
+                {
+                    return difference_dot( candidate, segment_start, candidate, segment_start );
+                }
+                else if ( projection >= segment_square_length )
+                {
+                    return helpers::get_point_point_square_distance< T >( candidate, segment_end );
+                }
+
+                return unrolled< 0, dimension >::residual_square_distance( candidate, segment_start, segment_end, projection / segment_square_length, static_cast< T >( 0 ) );
+            }
+        };
+
+        // The kernel used when none is given: native for float, exact for small integers (see below)
+        // and promoted otherwise.
+
+        template< class T, std::size_t dimension, class Enable = void >
+        struct distance_kernel : promoted_distance_kernel< T, dimension >
+        {
+        };
+
+        template< std::size_t dimension >
+        struct distance_kernel< float, dimension > : native_distance_kernel< float, dimension >
+        {
+        };
+
+        // Precision policy: points are stored as T, converted to Accumulate to compute distances
+        // with the native kernel, and distances and tolerances are compared as Compare. For
+        // instance, precision_kernel< float, 2, double > keeps float storage for coordinates of
+        // large magnitude, and precision_kernel< double, 2, float > trades precision for float
+        // lanes. Differences from the segment start are taken in the wider of T and Accumulate
+        // before the conversion, so Accumulate only needs to hold the differences between
+        // neighbouring points, not the absolute coordinates.
+
+        template< class T, std::size_t dimension, class Accumulate, class Compare = Accumulate >
+        struct precision_kernel
+        {
+            static_assert( std::is_floating_point< Accumulate >::value, "Accumulate is not a floating point type" );
+
+            typedef vect< T, dimension > vec;
+            typedef vect< Accumulate, dimension > accumulate_vec;
+            typedef typename std::common_type< T, Accumulate >::type difference;
+            typedef native_distance_kernel< Accumulate, dimension > accumulate_kernel;
+            typedef Compare point_square_distance;
+            typedef Compare segment_square_distance;
+
+            static point_square_distance get_point_square_tolerance( const T tolerance )
+            {
+                return static_cast< Compare >( static_cast< Accumulate >( tolerance ) * static_cast< Accumulate >( tolerance ) );
+            }
+
+            static segment_square_distance get_segment_square_tolerance( const T tolerance )
+            {
+                return get_point_square_tolerance( tolerance );
+            }
+
+            static SIMPLIFY_CONSTEXPR14 point_square_distance get_point_point_square_distance( const vec & first, const vec & second )
+            {
+                return static_cast< Compare >( accumulate_kernel::get_point_point_square_distance( get_difference( first, second ), accumulate_vec() ) );
+            }
+
+            static SIMPLIFY_CONSTEXPR14 segment_square_distance get_point_segment_square_distance( const vec & candidate, const vec & segment_start, const vec & segment_end )
+            {
+                return static_cast< Compare >(
+                    accumulate_kernel::get_point_segment_square_distance( get_difference( candidate, segment_start ), accumulate_vec(), get_difference( segment_end, segment_start ) )
+                    );
+            }
+
+        private:
+
+            static constexpr accumulate_vec get_difference( const vec & point, const vec & origin )
+            {
+                return vect_cast< Accumulate >( vect_cast< difference >( point ) - vect_cast< difference >( origin ) );
+            }
+        };
+
+        #if defined( __SIZEOF_INT128__ )
+
+        __extension__ typedef unsigned __int128 uint128;
+        __extension__ typedef __int128 int128;
+
+        // Multiplies two little-endian numbers of 64-bit limbs into result, which has
+        // first_size + second_size limbs.
+
+        inline void multiply_limbs(
+            const std::uint64_t * const first,
+            const std::size_t first_size,
+            const std::uint64_t * const second,
+            const std::size_t second_size,
+            std::uint64_t * const result
+            )
+        {
+            std::fill( result, result + first_size + second_size, std::uint64_t( 0 ) );
+
+            for ( std::size_t i = 0; i < first_size; ++i )
+            {
+                std::uint64_t carry = 0;
+
+                for ( std::size_t j = 0; j < second_size; ++j )
+                {
+                    const uint128 product = uint128( first[ i ] ) * second[ j ] + result[ i + j ] + carry;
+
+                    result[ i + j ] = std::uint64_t( product );
+                    carry = std::uint64_t( product >> 64 );
+                }
+
+                result[ i + second_size ] = carry;
+            }
+        }
+
+        // The same for two limbs times one, without the loops.
+
+        inline void multiply_short_limbs(
+            const std::uint64_t * const first,
+            const std::uint64_t second,
+            std::uint64_t * const result
+            )
+        {
+            const uint128 low = uint128( first[ 0 ] ) * second;
+            const uint128 high = uint128( first[ 1 ] ) * second + std::uint64_t( low >> 64 );
+
+            result[ 0 ] = std::uint64_t( low );
+            result[ 1 ] = std::uint64_t( high );
+            result[ 2 ] = std::uint64_t( high >> 64 );
+        }
+
+        inline int compare_limbs(
+            const std::uint64_t * const first,
+            const std::uint64_t * const second,
+            std::size_t size
+            )
+        {
+            while ( size-- )
+            {
+                if ( first[ size ] != second[ size ] )
+                {
+                    return first[ size ] < second[ size ] ? -1 : 1;
+                }
+            }
+
+            return 0;
+        }
+
+        // Exact squared distance of a point to a segment, kept as the fraction numerator / denominator
+        // so that no division is needed. The numerator is the squared distance times the squared
+        // segment length, which takes up to 256 bits for 32-bit coordinates.
+
+        struct exact_square_distance
+        {
+            exact_square_distance( const int value = 0 ) :
+                numerator { std::uint64_t( value < 0 ? 0 : value ), 0, 0, 0 },
+                denominator( 1 ),
+                is_negative( value < 0 )
+            {
+            }
+
+            exact_square_distance( const uint128 square_distance ) :
+                numerator { std::uint64_t( square_distance ), std::uint64_t( square_distance >> 64 ), 0, 0 },
+                denominator( 1 ),
+                is_negative( false )
+            {
+            }
+
+            exact_square_distance( const uint128 numerator, const uint128 denominator ) :
+                numerator { std::uint64_t( numerator ), std::uint64_t( numerator >> 64 ), 0, 0 },
+                denominator( denominator ),
+                is_negative( false )
+            {
+            }
+
+            std::uint64_t numerator[ 4 ];
+            uint128 denominator;
+            bool is_negative;
+        };
+
+        SIMPLIFY_NOINLINE inline int compare( const exact_square_distance & first, const exact_square_distance & second )
+        {
+            if ( first.is_negative || second.is_negative )
+            {
+                return int( second.is_negative ) - int( first.is_negative );
+            }
+
+            if ( first.denominator == second.denominator )
+            {
+                return compare_limbs( first.numerator, second.numerator, 4 );
+            }
+
+            if ( ( first.numerator[ 2 ] | first.numerator[ 3 ] | second.numerator[ 2 ] | second.numerator[ 3 ] | std::uint64_t( first.denominator >> 64 ) | std::uint64_t( second.denominator >> 64 ) ) == 0 )
+            {
+                std::uint64_t first_product[ 3 ], second_product[ 3 ];
+
+                multiply_short_limbs( first.numerator, std::uint64_t( second.denominator ), first_product );
+                multiply_short_limbs( second.numerator, std::uint64_t( first.denominator ), second_product );
+
+                return compare_limbs( first_product, second_product, 3 );
+            }
+
+            const std::uint64_t first_denominator[ 2 ] { std::uint64_t( first.denominator ), std::uint64_t( first.denominator >> 64 ) };
+            const std::uint64_t second_denominator[ 2 ] { std::uint64_t( second.denominator ), std::uint64_t( second.denominator >> 64 ) };
+            std::uint64_t first_product[ 6 ], second_product[ 6 ];
+
+            multiply_limbs( first.numerator, 4, second_denominator, 2, first_product );
+            multiply_limbs( second.numerator, 4, first_denominator, 2, second_product );
+
+            return compare_limbs( first_product, second_product, 6 );
+        }
+
+        // Douglas-Peucker mostly compares distances to the same segment, so their numerators are
+        // compared directly, as two 128-bit halves.
+
+        inline bool is_greater( const exact_square_distance & first, const exact_square_distance & second )
+        {
+            if ( first.denominator == second.denominator && !( first.is_negative | second.is_negative ) )
+            {
+                const uint128 first_high = uint128( first.numerator[ 3 ] ) << 64 | first.numerator[ 2 ];
+                const uint128 second_high = uint128( second.numerator[ 3 ] ) << 64 | second.numerator[ 2 ];
+                const uint128 first_low = uint128( first.numerator[ 1 ] ) << 64 | first.numerator[ 0 ];
+                const uint128 second_low = uint128( second.numerator[ 1 ] ) << 64 | second.numerator[ 0 ];
+
+                return first_high > second_high || ( first_high == second_high && first_low > second_low );
+            }
+
+            return compare( first, second ) > 0;
+        }
+
+        inline bool operator<( const exact_square_distance & first, const exact_square_distance & second ) { return is_greater( second, first ); }
+        inline bool operator>( const exact_square_distance & first, const exact_square_distance & second ) { return is_greater( first, second ); }
+        inline bool operator>=( const exact_square_distance & first, const exact_square_distance & second ) { return !is_greater( second, first ); }
+
+        // Integer coordinates up to 32 bits: differences are taken in 64 bits and products in 128 or
+        // 256 bits, so every comparison is exact, without floating point nor division. Differences
+        // within +/-2^30 in up to three dimensions, as in tiles and fixed-point data, take a 64-bit
+        // path with 128-bit numerators; the 256-bit limbs are only the fallback.
+        //
+        // This changes the results of simplify2i and simplify3i for existing callers: the former
+        // kernel rounded the projected point to integers, which made some distances larger than
+        // they are and kept points within the tolerance. The zigzag 0,0 1,1 2,0 3,1 4,0 now keeps
+        // 0,0 1,1 4,0 at tolerance 1 instead of all five points, as 2,0 and 3,1 lie 2/sqrt(10)
+        // from the segment between 1,1 and 4,0.
+
+        template< class T, std::size_t dimension >
+        struct distance_kernel< T, dimension, typename std::enable_if< std::is_integral< T >::value && sizeof( T ) <= 4 >::type >
+        {
+            typedef vect< T, dimension > vec;
+            typedef uint128 point_square_distance;
+            typedef exact_square_distance segment_square_distance;
+
+            static point_square_distance get_point_square_tolerance( const T tolerance )
+            {
+                const std::uint64_t magnitude = get_magnitude( tolerance );
+
+                return uint128( magnitude ) * magnitude;
+            }
+
+            static segment_square_distance get_segment_square_tolerance( const T tolerance )
+            {
+                return exact_square_distance( get_point_square_tolerance( tolerance ) );
+            }
+
+            static point_square_distance get_point_point_square_distance( const vec & first, const vec & second )
+            {
+                uint128 result = 0;
+
+                for ( std::size_t i = 0; i < dimension; ++i )
+                {
+                    const std::uint64_t magnitude = get_magnitude( (long long)( second.values[ i ] ) - first.values[ i ] );
+
+                    result += uint128( magnitude ) * magnitude;
+                }
+
+                return result;
+            }
+
+            static segment_square_distance get_point_segment_square_distance( const vec & candidate, const vec & segment_start, const vec & segment_end )
+            {
+                long long u[ dimension ], v[ dimension ];
+                std::uint64_t range_bits = 0;
+
+                for ( std::size_t i = 0; i < dimension; ++i )
+                {
+                    u[ i ] = (long long)( candidate.values[ i ] ) - segment_start.values[ i ];
+                    v[ i ] = (long long)( segment_end.values[ i ] ) - segment_start.values[ i ];
+                    range_bits |= std::uint64_t( u[ i ] + short_limit ) | std::uint64_t( v[ i ] + short_limit );
+                }
+
+                if ( dimension <= 3 && range_bits < std::uint64_t( 2 * short_limit ) )
+                {
+                    return get_short_point_segment_square_distance( u, v );
+                }
+
+                return get_long_point_segment_square_distance( candidate, segment_start, segment_end, u, v );
+            }
+
+        private:
+
+            // Any 32-bit coordinates, with the products in 256-bit limbs.
+
+            static SIMPLIFY_NOINLINE segment_square_distance get_long_point_segment_square_distance(
+                const vec & candidate,
+                const vec & segment_start,
+                const vec & segment_end,
+                const long long * const u,
+                const long long * const v
+                )
+            {
+                const uint128 segment_square_length = get_point_point_square_distance( segment_start, segment_end );
+
+                if ( segment_square_length == 0 )
+                {
+                    return exact_square_distance( get_point_point_square_distance( candidate, segment_start ) );
+                }
+
+                int128 projection = 0;
+
+                for ( std::size_t i = 0; i < dimension; ++i )
+                {
+                    projection += int128( u[ i ] ) * v[ i ];
+                }
+
+                // With u = candidate - segment_start and v = segment_end - segment_start, the squared
+                // distance times |v|^2 is |u|^2 |v|^2 - ( u.v )^2 inside the segment, and the squared
+                // distance to the nearest end times |v|^2 outside of it.
+
+                exact_square_distance result;
+                const bool is_past_end = projection > int128( segment_square_length );
+                const uint128 near_square_distance = get_point_point_square_distance( candidate, is_past_end ? segment_end : segment_start );
+                const std::uint64_t length_limbs[ 2 ] { std::uint64_t( segment_square_length ), std::uint64_t( segment_square_length >> 64 ) };
+                const std::uint64_t near_limbs[ 2 ] { std::uint64_t( near_square_distance ), std::uint64_t( near_square_distance >> 64 ) };
+
+                result.denominator = segment_square_length;
+                multiply_limbs( near_limbs, 2, length_limbs, 2, result.numerator );
+
+                if ( !is_past_end && projection > 0 )
+                {
+                    const uint128 projection_magnitude = uint128( projection );
+                    const std::uint64_t projection_limbs[ 2 ] { std::uint64_t( projection_magnitude ), std::uint64_t( projection_magnitude >> 64 ) };
+                    std::uint64_t projection_square[ 4 ];
+                    std::uint64_t borrow = 0;
+
+                    multiply_limbs( projection_limbs, 2, projection_limbs, 2, projection_square );
+
+                    for ( std::size_t i = 0; i < 4; ++i )
+                    {
+                        const uint128 difference = uint128( result.numerator[ i ] ) - projection_square[ i ] - borrow;
+
+                        result.numerator[ i ] = std::uint64_t( difference );
+                        borrow = std::uint64_t( difference >> 64 ) ? 1 : 0;
+                    }
+                }
+
+                return result;
+            }
+
+            // The same when every difference is within +/-2^30, in at most three dimensions: squared
+            // lengths and the projection fit in 64 bits, and the numerator in 126, so it takes two
+            // 64 x 64 bit products instead of the 256-bit limbs.
+
+            static const long long short_limit = 1ll << 30;
+
+            static segment_square_distance get_short_point_segment_square_distance( const long long * const u, const long long * const v )
+            {
+                std::uint64_t segment_square_length = 0;
+                long long projection = 0;
+
+                for ( std::size_t i = 0; i < dimension; ++i )
+                {
+                    segment_square_length += std::uint64_t( v[ i ] * v[ i ] );
+                    projection += u[ i ] * v[ i ];
+                }
+
+                if ( segment_square_length == 0 || projection <= 0 || projection > (long long)( segment_square_length ) )
+                {
+                    const bool is_past_end = segment_square_length != 0 && projection > 0;
+                    std::uint64_t near_square_distance = 0;
+
+                    for ( std::size_t i = 0; i < dimension; ++i )
+                    {
+                        const long long w = is_past_end ? u[ i ] - v[ i ] : u[ i ];
+
+                        near_square_distance += std::uint64_t( w * w );
+                    }
+
+                    return segment_square_length == 0
+                        ? exact_square_distance( uint128( near_square_distance ) )
+                        : exact_square_distance( uint128( near_square_distance ) * segment_square_length, segment_square_length );
+                }
+
+                std::uint64_t start_square_distance = 0;
+
+                for ( std::size_t i = 0; i < dimension; ++i )
+                {
+                    start_square_distance += std::uint64_t( u[ i ] * u[ i ] );
+                }
+
+                return exact_square_distance(
+                    uint128( start_square_distance ) * segment_square_length - uint128( std::uint64_t( projection ) ) * std::uint64_t( projection ),
+                    segment_square_length
+                    );
+            }
+
+            static std::uint64_t get_magnitude( const long long value )
+            {
+                return value < 0 ? std::uint64_t( 0 ) - std::uint64_t( value ) : std::uint64_t( value );
+            }
+        };
+
+        // Exact squared distance for int16_t 2D points, as cross_square / segment_square_length. With
+        // 17-bit differences, the numerator takes 66 bits and the denominator 33, so comparisons only
+        // need one 128-bit product on each side.
+
+        struct short_exact_square_distance
+        {
+            short_exact_square_distance( const int value = 0 ) :
+                numerator( std::uint64_t( value < 0 ? 0 : value ) ),
+                denominator( 1 ),
+                is_negative( value < 0 )
+            {
+            }
+
+            short_exact_square_distance( const uint128 numerator, const std::uint64_t denominator ) :
+                numerator( numerator ),
+                denominator( denominator ),
+                is_negative( false )
+            {
+            }
+
+            uint128 numerator;
+            std::uint64_t denominator;
+            bool is_negative;
+        };
+
+        inline int compare( const short_exact_square_distance & first, const short_exact_square_distance & second )
+        {
+            if ( first.is_negative || second.is_negative )
+            {
+                return int( second.is_negative ) - int( first.is_negative );
+            }
+
+            const uint128 first_product = first.numerator * second.denominator;
+            const uint128 second_product = second.numerator * first.denominator;
+
+            return first_product < second_product ? -1 : first_product > second_product ? 1 : 0;
+        }
+
+        inline bool operator<( const short_exact_square_distance & first, const short_exact_square_distance & second ) { return compare( first, second ) < 0; }
+        inline bool operator>( const short_exact_square_distance & first, const short_exact_square_distance & second ) { return compare( first, second ) > 0; }
+        inline bool operator>=( const short_exact_square_distance & first, const short_exact_square_distance & second ) { return compare( first, second ) >= 0; }
+
+        // Tile-local int16_t 2D points, as stored by vector tiles: differences are taken in 32 bits
+        // and products in 64, and only the segment distance comparisons go to 128 bits. Results are
+        // exact, and identical to the generic integer kernel, on the whole int16_t range. There is
+        // no packed 16-bit path, as squared differences need 34 bits: the gain is the halved storage
+        // and skipping the widening copy, at about the speed the int kernel had before it was exact.
+
+        template<>
+        struct distance_kernel< std::int16_t, 2 >
+        {
+            typedef vect< std::int16_t, 2 > vec;
+            typedef std::uint64_t point_square_distance;
+            typedef short_exact_square_distance segment_square_distance;
+
+            static point_square_distance get_point_square_tolerance( const std::int16_t tolerance )
+            {
+                return std::uint64_t( std::int64_t( tolerance ) * tolerance );
+            }
+
+            static segment_square_distance get_segment_square_tolerance( const std::int16_t tolerance )
+            {
+                return short_exact_square_distance( get_point_square_tolerance( tolerance ), 1 );
+            }
+
+            static point_square_distance get_point_point_square_distance( const vec & first, const vec & second )
+            {
+                const std::int32_t x = std::int32_t( second.values[ 0 ] ) - first.values[ 0 ];
+                const std::int32_t y = std::int32_t( second.values[ 1 ] ) - first.values[ 1 ];
+
+                return std::uint64_t( std::int64_t( x ) * x ) + std::uint64_t( std::int64_t( y ) * y );
+            }
+
+            static segment_square_distance get_point_segment_square_distance( const vec & candidate, const vec & segment_start, const vec & segment_end )
+            {
+                const std::int32_t u_x = std::int32_t( candidate.values[ 0 ] ) - segment_start.values[ 0 ];
+                const std::int32_t u_y = std::int32_t( candidate.values[ 1 ] ) - segment_start.values[ 1 ];
+                const std::int32_t v_x = std::int32_t( segment_end.values[ 0 ] ) - segment_start.values[ 0 ];
+                const std::int32_t v_y = std::int32_t( segment_end.values[ 1 ] ) - segment_start.values[ 1 ];
+                const std::uint64_t segment_square_length = std::uint64_t( std::int64_t( v_x ) * v_x ) + std::uint64_t( std::int64_t( v_y ) * v_y );
+                const std::int64_t projection = std::int64_t( u_x ) * v_x + std::int64_t( u_y ) * v_y;
+
+                // Same cases as the generic integer kernel, with the squared distance inside the
+                // segment taken as cross( u, v )^2 / |v|^2.
+
+                if ( segment_square_length == 0 || projection <= 0 )
+                {
+                    return short_exact_square_distance( std::uint64_t( std::int64_t( u_x ) * u_x ) + std::uint64_t( std::int64_t( u_y ) * u_y ), 1 );
+                }
+                else if ( projection > std::int64_t( segment_square_length ) )
+                {
+                    return short_exact_square_distance( get_point_point_square_distance( candidate, segment_end ), 1 );
+                }
+
+                const std::int64_t cross = std::int64_t( u_x ) * v_y - std::int64_t( u_y ) * v_x;
+                const std::uint64_t cross_magnitude = cross < 0 ? std::uint64_t( 0 ) - std::uint64_t( cross ) : std::uint64_t( cross );
+
+                return short_exact_square_distance( uint128( cross_magnitude ) * cross_magnitude, segment_square_length );
+            }
+        };
+
+        #endif
+
+        template< class T, std::size_t dimension >
+        vect< long long, dimension > get_point_cell(
+            const vect< T, dimension > & point,
+            const T cell_size
+            )
+        {
+            vect< long long, dimension > result;
+
+            for ( std::size_t i = 0; i < dimension; ++i )
+            {
+                result.values[ i ] = static_cast< long long >( std::floor( double( point.values[ i ] ) / double( cell_size ) ) );
+            }
+
+            return result;
+        }
+
+        // Same result as ::simplify::simplify_radial_distance with get_point_point_square_distance, on
+        // contiguous points. Every candidate up to the next kept point is measured against the same
+        // anchor, so a whole block is tested without any branch, and the scan then jumps straight to
+        // the first point to keep, or over the block when there is none. A block retests the points
+        // after the one it keeps, so where most points are kept (a block keeping its first candidate,
+        // or two blocks in a row keeping one) the scan goes on point by point until it sees a whole
+        // block of dropped points again.
+
+        template< class T, std::size_t dimension, class Kernel, class OnKept >
+        vect< T, dimension > * simplify_radial_distance(
+            vect< T, dimension > * const first,
+            vect< T, dimension > * const last,
+            const T tolerance,
+            OnKept on_kept
+            )
+        {
+            typedef vect< T, dimension > vec;
+
+            const std::size_t block_size = 16;
+
+            if ( last - first <= 2 )
+            {
+                return last;
+            }
+
+            typedef Kernel kernel;
+
+            const auto square_tolerance = kernel::get_point_square_tolerance( tolerance );
+            vec anchor = *first;
+            const vec * last_kept_it = first;
+            vec * write_it = first + 1;
+            const vec * it = first + 1;
+
+            auto is_kept = [ & ]( const vec & candidate )
+            {
+                return !( kernel::get_point_point_square_distance( candidate, anchor ) < square_tolerance );
+            };
+
+            auto keep = [ & ]( const vec * kept_it )
+            {
+                last_kept_it = kept_it;
+                anchor = *kept_it;
+                *write_it = anchor;
+                on_kept( last_kept_it, write_it++ );
+            };
+
+            bool is_dense = false, has_kept_in_previous_block = false;
+            std::size_t dropped_count = 0;
+
+            while ( static_cast< std::size_t >( last - it ) >= block_size )
+            {
+                if ( is_dense )
+                {
+                    if ( is_kept( *it ) )
+                    {
+                        keep( it );
+                        dropped_count = 0;
+                    }
+                    else if ( ++dropped_count == block_size )
+                    {
+                        is_dense = false;
+                        has_kept_in_previous_block = false;
+                    }
+
+                    ++it;
+                    continue;
+                }
+
+                unsigned char is_kept_table[ block_size ], any_kept = 0;
+
+                for ( std::size_t i = 0; i < block_size; ++i )
+                {
+                    is_kept_table[ i ] = is_kept( it[ i ] );
+                    any_kept |= is_kept_table[ i ];
+                }
+
+                if ( !any_kept )
+                {
+                    it += block_size;
+                    has_kept_in_previous_block = false;
+                    continue;
+                }
+
+                const std::size_t kept_index = std::find( is_kept_table, is_kept_table + block_size, 1 ) - is_kept_table;
+                keep( it + kept_index );
+                it += kept_index + 1;
+                is_dense = kept_index == 0 || has_kept_in_previous_block;
+                has_kept_in_previous_block = true;
+                dropped_count = 0;
+            }
+
+            for ( ; it != last; ++it )
+            {
+                if ( is_kept( *it ) )
+                {
+                    keep( it );
+                }
+            }
+
+            if ( last_kept_it != last - 1 )
+            {
+                *write_it = *( last - 1 );
+                on_kept( last - 1, write_it++ );
+            }
+
+            return write_it;
+        }
+
+        template< class T, std::size_t dimension, class Kernel = distance_kernel< T, dimension > >
+        vect< T, dimension > * simplify_radial_distance(
+            vect< T, dimension > * const first,
+            vect< T, dimension > * const last,
+            const T tolerance
+            )
+        {
+            return simplify_radial_distance< T, dimension, Kernel >( first, last, tolerance, []( const vect< T, dimension > *, vect< T, dimension > * ) {} );
+        }
+
+        // Bounding boxes of the points of a polyline by aligned blocks: fan_out points per box at
+        // level 0, fan_out^2 at level 1 and so on. The partial blocks at the end have no box.
+
+        template< class T, std::size_t dimension >
+        struct douglas_peucker_box_tree
+        {
+            typedef vect< T, dimension > vec;
+
+            enum { fan_out = 32 };
+
+            bool is_built() const
+            {
+                return !minimum_table.empty();
+            }
+
+            void build( const vec * const first, const std::size_t point_count )
+            {
+                for ( std::size_t node_size = fan_out; node_size <= point_count; node_size *= fan_out )
+                {
+                    const std::size_t level = minimum_table.size();
+                    const std::size_t node_count = point_count / node_size;
+
+                    minimum_table.emplace_back( node_count );
+                    maximum_table.emplace_back( node_count );
+
+                    for ( std::size_t node = 0; node < node_count; ++node )
+                    {
+                        vec & minimum = minimum_table[ level ][ node ];
+                        vec & maximum = maximum_table[ level ][ node ];
+                        const vec * const child_minimum_it = level == 0 ? first + node * fan_out : &minimum_table[ level - 1 ][ node * fan_out ];
+                        const vec * const child_maximum_it = level == 0 ? child_minimum_it : &maximum_table[ level - 1 ][ node * fan_out ];
+
+                        minimum = child_minimum_it[ 0 ];
+                        maximum = child_maximum_it[ 0 ];
+
+                        for ( std::size_t child = 1; child < fan_out; ++child )
+                        {
+                            for ( std::size_t i = 0; i < dimension; ++i )
+                            {
+                                minimum.values[ i ] = std::min( minimum.values[ i ], child_minimum_it[ child ].values[ i ] );
+                                maximum.values[ i ] = std::max( maximum.values[ i ], child_maximum_it[ child ].values[ i ] );
+                            }
+                        }
+                    }
+
+                    byte_count += 2 * node_count * sizeof( vec );
+                }
+            }
+
+            std::vector< std::vector< vec > > minimum_table, maximum_table;
+            std::size_t byte_count = 0;
+        };
+
+        // Largest absolute coordinate of the segment ends, the magnitude its rounding is relative to.
+
+        template< class T, std::size_t dimension >
+        double get_segment_magnitude(
+            const vect< T, dimension > & segment_start,
+            const vect< T, dimension > & segment_end
+            )
+        {
+            double magnitude = 0.0;
+
+            for ( std::size_t i = 0; i < dimension; ++i )
+            {
+                magnitude = std::max( magnitude, double( std::abs( segment_start.values[ i ] ) ) );
+                magnitude = std::max( magnitude, double( std::abs( segment_end.values[ i ] ) ) );
+            }
+
+            return magnitude;
+        }
+
+        // Bounds the squared distance computed by Kernel from any point of the box between
+        // minimum_corner and maximum_corner to the segment. The distance to a segment is convex, so
+        // over a box it peaks at a corner: the largest corner distance, widened by the rounding of
+        // the kernels (a few epsilons of T, or of double for the projection parameter of the
+        // promoted kernel, of the coordinate magnitude and of the distances to the segment ends),
+        // bounds the computed distance of every point in the box.
+
+        template< class T, std::size_t dimension, class Kernel >
+        double get_box_segment_square_bound(
+            const vect< T, dimension > & minimum_corner,
+            const vect< T, dimension > & maximum_corner,
+            const vect< T, dimension > & segment_start,
+            const vect< T, dimension > & segment_end,
+            const double segment_magnitude
+            )
+        {
+            const double epsilon = std::max< double >( std::numeric_limits< T >::epsilon(), std::numeric_limits< double >::epsilon() );
+            double corner_square_distance = 0.0, reach_square_distance = 0.0, magnitude = segment_magnitude;
+
+            for ( std::size_t mask = 0; mask < ( std::size_t( 1 ) << dimension ); ++mask )
+            {
+                vect< T, dimension > corner;
+                double start_square_distance = 0.0, end_square_distance = 0.0;
+
+                for ( std::size_t i = 0; i < dimension; ++i )
+                {
+                    corner.values[ i ] = ( ( mask >> i ) & 1 ) ? maximum_corner.values[ i ] : minimum_corner.values[ i ];
+
+                    const double start_offset = double( corner.values[ i ] ) - double( segment_start.values[ i ] );
+                    const double end_offset = double( corner.values[ i ] ) - double( segment_end.values[ i ] );
+
+                    magnitude = std::max( magnitude, double( std::abs( corner.values[ i ] ) ) );
+                    start_square_distance += start_offset * start_offset;
+                    end_square_distance += end_offset * end_offset;
+                }
+
+                corner_square_distance = std::max( corner_square_distance, double( Kernel::get_point_segment_square_distance( corner, segment_start, segment_end ) ) );
+                reach_square_distance = std::max( reach_square_distance, std::max( start_square_distance, end_square_distance ) );
+            }
+
+            const double slack = 64.0 * epsilon * ( std::sqrt( reach_square_distance ) + magnitude );
+            const double bound = std::sqrt( corner_square_distance ) + 2.0 * slack;
+
+            return bound * bound * ( 1.0 + 16.0 * epsilon );
+        }
+
+        // Finds the farthest point from a segment like process_douglas_peucker_ranges, through the
+        // boxes of a douglas_peucker_box_tree, bounded by get_box_segment_square_bound.
+        //
+        // Boxes are expanded best first, by decreasing bound, and the search stops at the first box
+        // whose bound is below the maximum found. The box holding the farthest point, and all its
+        // ancestors, bound at least that distance M, so that point is found before any box bounding
+        // less than M is expanded: exactly the boxes bounding M or more are expanded. As a bound
+        // exceeds the distance of the points of its box by at most the box diagonal plus the
+        // rounding margin, a range costs O( 2^dimension fan_out levels ) evaluations per box holding
+        // a point that close to M, instead of its length, and never more than the plain scan plus
+        // the corners of the boxes below it. Equal distances go to the first point, as in the plain
+        // scan, so the split is the same.
+
+        template< class T, std::size_t dimension, class Kernel >
+        struct douglas_peucker_box_search
+        {
+            typedef vect< T, dimension > vec;
+            typedef typename Kernel::segment_square_distance Distance;
+            typedef douglas_peucker_box_tree< T, dimension > box_tree;
+
+            struct candidate
+            {
+                double square_bound;
+                std::size_t level, node;
+
+                bool operator<( const candidate & other ) const
+                {
+                    return square_bound < other.square_bound;
+                }
+            };
+
+            douglas_peucker_box_search( const box_tree & tree, vec * const first ) :
+                tree( tree ),
+                first( first )
+            {
+            }
+
+            // Sets maximum and maximum_it for the points strictly between the segment ends.
+
+            void find_farthest( vec * const segment_start_it, vec * const segment_end_it )
+            {
+                const std::size_t level_count = tree.minimum_table.size();
+                std::size_t index = segment_start_it - first + 1;
+                const std::size_t last_index = segment_end_it - first;
+
+                segment_start = *segment_start_it;
+                segment_end = *segment_end_it;
+                segment_magnitude = get_segment_magnitude( segment_start, segment_end );
+                maximum = static_cast< Distance >( -1 );
+                maximum_it = segment_start_it;
+                candidate_table.clear();
+
+                // The range is covered by the largest aligned boxes inside it, and single points at
+                // its ends.
+
+                while ( index < last_index )
+                {
+                    std::size_t level = 0, node_size = box_tree::fan_out;
+
+                    if ( index % node_size != 0 || index + node_size > last_index )
+                    {
+                        evaluate( index++ );
+                        continue;
+                    }
+
+                    while ( level + 1 < level_count && index % ( node_size * box_tree::fan_out ) == 0 && index + node_size * box_tree::fan_out <= last_index )
+                    {
+                        ++level;
+                        node_size *= box_tree::fan_out;
+                    }
+
+                    push( level, index / node_size );
+                    index += node_size;
+                }
+
+                while ( !candidate_table.empty() )
+                {
+                    std::pop_heap( candidate_table.begin(), candidate_table.end() );
+
+                    const candidate current = candidate_table.back();
+
+                    candidate_table.pop_back();
+
+                    if ( current.square_bound < double( maximum ) )
+                    {
+                        break;
+                    }
+
+                    for ( std::size_t child = current.node * box_tree::fan_out; child < ( current.node + 1 ) * box_tree::fan_out; ++child )
+                    {
+                        if ( current.level == 0 )
+                        {
+                            evaluate( child );
+                        }
+                        else
+                        {
+                            push( current.level - 1, child );
+                        }
+                    }
+                }
+            }
+
+            void evaluate( const std::size_t index )
+            {
+                const Distance square_distance = Kernel::get_point_segment_square_distance( first[ index ], segment_start, segment_end );
+
+                ++evaluation_count;
+
+                if ( square_distance > maximum || ( square_distance == maximum && first + index < maximum_it ) )
+                {
+                    maximum = square_distance;
+                    maximum_it = first + index;
+                }
+            }
+
+            void push( const std::size_t level, const std::size_t node )
+            {
+                const double square_bound = get_box_segment_square_bound< T, dimension, Kernel >( tree.minimum_table[ level ][ node ], tree.maximum_table[ level ][ node ], segment_start, segment_end, segment_magnitude );
+
+                evaluation_count += std::size_t( 1 ) << dimension;
+
+                if ( square_bound >= double( maximum ) )
+                {
+                    candidate_table.push_back( candidate { square_bound, level, node } );
+                    std::push_heap( candidate_table.begin(), candidate_table.end() );
+                }
+            }
+
+            const box_tree & tree;
+            vec * const first;
+            vec segment_start, segment_end;
+            double segment_magnitude = 0.0;
+            Distance maximum = static_cast< Distance >( -1 );
+            vec * maximum_it = nullptr;
+            std::size_t evaluation_count = 0;
+            std::vector< candidate > candidate_table;
+        };
+
+        // The box search needs floating point coordinates, a kernel whose rounding it knows and a few
+        // corners per box.
+
+        template< class T, std::size_t dimension, class Kernel >
+        struct is_box_scan_supported : std::integral_constant<
+            bool,
+            std::is_floating_point< T >::value
+                && dimension <= 4
+                && ( std::is_same< Kernel, distance_kernel< T, dimension > >::value
+                    || std::is_same< Kernel, promoted_distance_kernel< T, dimension > >::value
+                    || std::is_same< Kernel, native_distance_kernel< T, dimension > >::value )
+            >
+        {
+        };
+
+        template< class T, std::size_t dimension, class Kernel, class Statistics >
+        vect< T, dimension > * process_guarded_douglas_peucker_ranges(
+            vect< T, dimension > * const first,
+            vect< T, dimension > * const last_included,
+            const typename Kernel::segment_square_distance square_tolerance,
+            douglas_peucker_scratch< vect< T, dimension > *, Statistics > & scratch,
+            std::false_type
+            )
+        {
+            return ::simplify::process_douglas_peucker_ranges( first, last_included, square_tolerance, &Kernel::get_point_segment_square_distance, scratch );
+        }
+
+        // process_douglas_peucker_ranges with a guard against degenerate inputs, such as spirals or
+        // zigzags, where each range splits next to one of its ends and the scans add up to O(n^2).
+        // Once the points scanned exceed 4 n log2( n ), the farthest point of each remaining range
+        // is found by a douglas_peucker_box_search over a douglas_peucker_box_tree of the polyline
+        // instead. The splits, and so the output, are the same either way.
+
+        template< class T, std::size_t dimension, class Kernel, class Statistics >
+        vect< T, dimension > * process_guarded_douglas_peucker_ranges(
+            vect< T, dimension > * first,
+            vect< T, dimension > * const last_included,
+            const typename Kernel::segment_square_distance square_tolerance,
+            douglas_peucker_scratch< vect< T, dimension > *, Statistics > & scratch,
+            std::true_type
+            )
+        {
+            typedef vect< T, dimension > vec;
+            typedef typename Kernel::segment_square_distance Distance;
+
+            auto & range_to_process_table = scratch.range_to_process_table;
+            auto & to_keep_table = scratch.to_keep_table;
+            const std::size_t point_count = last_included - first + 1;
+            std::size_t maximum_range_depth = range_to_process_table.size();
+            std::size_t scanned_count = 0, scan_budget = 0;
+            douglas_peucker_box_tree< T, dimension > tree;
+            douglas_peucker_box_search< T, dimension, Kernel > box_search( tree, first );
+
+            for ( std::size_t count = point_count; count > 1; count >>= 1 )
+            {
+                scan_budget += 4 * point_count;
+            }
+
+            to_keep_table.clear();
+            to_keep_table.push_back( first );
+            scratch.statistics.update_range_depth( maximum_range_depth );
+
+            while( !range_to_process_table.empty() )
+            {
+                const auto range = range_to_process_table.top();
+                auto maximum = static_cast< Distance >( -1 );
+                vec * current_maximum_it = range.first;
+
+                if ( to_keep_table.back() != range.first )
+                    to_keep_table.push_back( range.first );
+
+                range_to_process_table.pop();
+
+                if ( tree.is_built() )
+                {
+                    box_search.evaluation_count = 0;
+                    box_search.find_farthest( range.first, range.second );
+                    scratch.statistics.add_metric_evaluation_count( box_search.evaluation_count );
+                    maximum = box_search.maximum;
+                    current_maximum_it = box_search.maximum_it;
+                }
+                else
+                {
+                    for( vec * it = range.first + 1; it != range.second; ++it )
+                    {
+                        const Distance square_distance = Kernel::get_point_segment_square_distance( *it, *range.first, *range.second );
+
+                        if ( square_distance > maximum )
+                        {
+                            maximum = square_distance;
+                            current_maximum_it = it;
+                        }
+                    }
+
+                    scratch.statistics.add_metric_evaluation_count( range.second - range.first - 1 );
+                    scanned_count += range.second - range.first - 1;
+
+                    if ( scanned_count > scan_budget )
+                    {
+                        tree.build( first, point_count );
+                    }
+                }
+
+                if ( maximum >= square_tolerance )
+                {
+                    range_to_process_table.push( std::make_pair( current_maximum_it, range.second ) );
+                    range_to_process_table.push( std::make_pair( range.first, current_maximum_it ) );
+                    maximum_range_depth = std::max( maximum_range_depth, range_to_process_table.size() );
+                    scratch.statistics.add_split();
+                    scratch.statistics.update_range_depth( range_to_process_table.size() );
+                }
+            }
+
+            to_keep_table.push_back( last_included );
+            scratch.statistics.update_scratch_byte_count( maximum_range_depth * sizeof( range_to_process_table.top() ) + to_keep_table.size() * sizeof( vec * ) + tree.byte_count );
+
+            for( auto it = to_keep_table.begin(); it != to_keep_table.end(); ++it )
+            {
+                *first++ = std::move( **it );
+            }
+
+            return first;
+        }
+
+        template< class T, std::size_t dimension, class Kernel, class Statistics >
+        vect< T, dimension > * process_guarded_douglas_peucker_ranges(
+            vect< T, dimension > * const first,
+            vect< T, dimension > * const last_included,
+            const typename Kernel::segment_square_distance square_tolerance,
+            douglas_peucker_scratch< vect< T, dimension > *, Statistics > & scratch
+            )
+        {
+            return process_guarded_douglas_peucker_ranges< T, dimension, Kernel >( first, last_included, square_tolerance, scratch, is_box_scan_supported< T, dimension, Kernel >() );
+        }
+
+        // Same result as ::simplify::simplify_radial_douglas_peucker with the functions above: the
+        // farthest survivor from the top-level segment is tracked by the block-scan radial pass.
+        // Radial metric evaluations are counted once per point, though the block scan may measure
+        // some points twice.
+
+        template< class T, std::size_t dimension, class Kernel = distance_kernel< T, dimension >, class Statistics = no_statistics >
+        vect< T, dimension > * simplify_radial_douglas_peucker(
+            vect< T, dimension > * const first,
+            vect< T, dimension > * last,
+            const T tolerance,
+            douglas_peucker_scratch< vect< T, dimension > *, Statistics > & scratch
+            )
+        {
+            typedef vect< T, dimension > vec;
+            typedef Kernel kernel;
+            typedef typename kernel::segment_square_distance Distance;
+
+            if ( last - first <= 2 )
+            {
+                return last;
+            }
+
+            const Distance square_tolerance = kernel::get_segment_square_tolerance( tolerance );
+            const vec segment_end = *( last - 1 );
+            const vec * const last_item_it = last - 1;
+            vec * maximum_it = first;
+            auto maximum = static_cast< Distance >( -1 );
+
+            scratch.statistics.add_metric_evaluation_count( static_cast< std::size_t >( last - first ) - 1 );
+
+            last = simplify_radial_distance< T, dimension, Kernel >( first, last, tolerance, [ & ]( const vec * kept_it, vec * written_it )
+            {
+                scratch.statistics.add_radial_kept_count( 1 );
+
+                if ( kept_it != last_item_it )
+                {
+                    const Distance square_distance = kernel::get_point_segment_square_distance( *written_it, *first, segment_end );
+
+                    scratch.statistics.add_metric_evaluation_count( 1 );
+
+                    if ( square_distance > maximum )
+                    {
+                        maximum = square_distance;
+                        maximum_it = written_it;
+                    }
+                }
+            } );
+
+            if ( maximum >= square_tolerance )
+            {
+                scratch.range_to_process_table.push( std::make_pair( maximum_it, last - 1 ) );
+                scratch.range_to_process_table.push( std::make_pair( first, maximum_it ) );
+                scratch.statistics.add_split();
+            }
+
+            return process_guarded_douglas_peucker_ranges< T, dimension, Kernel >( first, last - 1, square_tolerance, scratch );
+        }
+
+        // Same result as ::simplify::simplify_douglas_peucker with the Kernel functions.
+
+        template< class T, std::size_t dimension, class Kernel = distance_kernel< T, dimension >, class Statistics = no_statistics >
+        vect< T, dimension > * simplify_douglas_peucker(
+            vect< T, dimension > * const first,
+            vect< T, dimension > * const last,
+            const T tolerance,
+            douglas_peucker_scratch< vect< T, dimension > *, Statistics > & scratch
+            )
+        {
+            typedef Kernel kernel;
+
+            if ( last - first <= 2 )
+            {
+                return last;
+            }
+
+            scratch.range_to_process_table.push( std::make_pair( first, last - 1 ) );
+
+            return process_guarded_douglas_peucker_ranges< T, dimension, Kernel >( first, last - 1, kernel::get_segment_square_tolerance( tolerance ), scratch );
+        }
+
+        // Compacts away the interior points of [ first, last ) for which is_dropped( points, index )
+        // holds, keeping both ends. The predicate is evaluated branch-free a block at a time against
+        // the original points (a point only gets overwritten by itself until something is dropped),
+        // and blocks with nothing to drop are moved as a whole, or skipped while nothing was dropped.
+
+        template< class Vector, class IsDropped >
+        Vector * remove_interior_points_if(
+            Vector * const first,
+            Vector * const last,
+            IsDropped is_dropped
+            )
+        {
+            const std::size_t point_count = last - first;
+            const std::size_t block_size = 16;
+
+            if ( point_count <= 2 )
+            {
+                return last;
+            }
+
+            Vector * write_it = first + 1;
+            bool is_dropped_table[ block_size ];
+
+            for ( std::size_t block_first = 1; block_first + 1 < point_count; block_first += block_size )
+            {
+                const std::size_t block_count = std::min( block_size, point_count - 1 - block_first );
+                std::size_t dropped_count = 0;
+
+                for ( std::size_t i = 0; i < block_count; ++i )
+                {
+                    is_dropped_table[ i ] = is_dropped( first, block_first + i );
+                    dropped_count += is_dropped_table[ i ];
+                }
+
+                if ( dropped_count == 0 )
+                {
+                    if ( write_it != first + block_first )
+                    {
+                        std::move( first + block_first, first + block_first + block_count, write_it );
+                    }
+
+                    write_it += block_count;
+                }
+                else
+                {
+                    for ( std::size_t i = 0; i < block_count; ++i )
+                    {
+                        if ( !is_dropped_table[ i ] )
+                        {
+                            *write_it++ = std::move( first[ block_first + i ] );
+                        }
+                    }
+                }
+            }
+
+            *write_it++ = std::move( *( last - 1 ) );
+
+            return write_it;
+        }
+
+        // Drops the points equal to their predecessor, then the interior points lying on the line
+        // between their neighbours while going on in the same direction. Integer products are
+        // computed in long long, so collinearity is exact for integer coordinates within +/-2^30,
+        // and the polyline shape is unchanged. For floating point T, differences and products are
+        // rounded before they are compared, so collinearity is only approximate: a point a few ulps
+        // off the line can be dropped, moving the shape by that much, and a point on it can be kept.
+
+        template< class T, std::size_t dimension >
+        vect< T, dimension > * remove_redundant_points(
+            vect< T, dimension > * const first,
+            vect< T, dimension > * last
+            )
+        {
+            typedef vect< T, dimension > vec;
+            typedef typename std::conditional< std::is_integral< T >::value, long long, T >::type Product;
+
+            last = remove_interior_points_if( first, last, []( const vec * points, std::size_t index )
+            {
+                return points[ index ] == points[ index - 1 ];
+            } );
+
+            if ( last - first > 2 && *( last - 1 ) == *( last - 2 ) )
+            {
+                --last;
+            }
+
+            return remove_interior_points_if( first, last, []( const vec * points, std::size_t index )
+            {
+                const vec & previous = points[ index - 1 ];
+                const vec & current = points[ index ];
+                const vec & next = points[ index + 1 ];
+                bool is_collinear = true;
+                Product direction = 0;
+
+                for ( std::size_t j = 0; j < dimension; ++j )
+                {
+                    const Product incoming_j = Product( current.values[ j ] ) - Product( previous.values[ j ] );
+                    const Product outgoing_j = Product( next.values[ j ] ) - Product( current.values[ j ] );
+
+                    direction += incoming_j * outgoing_j;
+
+                    for ( std::size_t k = j + 1; k < dimension; ++k )
+                    {
+                        const Product incoming_k = Product( current.values[ k ] ) - Product( previous.values[ k ] );
+                        const Product outgoing_k = Product( next.values[ k ] ) - Product( current.values[ k ] );
+
+                        is_collinear &= incoming_j * outgoing_k == incoming_k * outgoing_j;
+                    }
+                }
+
+                return is_collinear & ( direction > 0 );
+            } );
+        }
+
+        // Pass run by simplify before Douglas-Peucker: simplify_radial_distance, simplify_grid_snap
+        // with get_point_cell, or nothing, which gives the highest quality.
+
+        enum class pre_pass
+        {
+            radial_distance,
+            grid_snap,
+            none
+        };
+
+        // Whether simplify runs remove_redundant_points first.
+
+        enum class redundant_points
+        {
+            keep,
+            remove
+        };
+
+        // Kernel selects the distance functions, see distance_kernel. For float, passing
+        // promoted_distance_kernel< float, dimension > opts back into double projection parameters.
+
+        template< class T, std::size_t dimension, class Kernel = distance_kernel< T, dimension > >
+        T * simplify(
+            T * const first,
+            T * const last,
+            const T tolerance,
+            const pre_pass pass,
+            const redundant_points redundant = redundant_points::keep
+            )
+        {
+            static_assert( std::is_arithmetic< T >::value, "T is not an arithmetic type" );
+
+            typedef vect< T, dimension > vec;
+
+            vec * vector_last = reinterpret_cast< vec * >( last );
+            douglas_peucker_scratch< vec * > scratch;
+
+            if ( redundant == redundant_points::remove )
+            {
+                vector_last = remove_redundant_points( reinterpret_cast< vec * >( first ), vector_last );
+            }
+
+            if ( pass == pre_pass::grid_snap )
+            {
+                vector_last = ::simplify::simplify_grid_snap( reinterpret_cast< vec * >( first ), vector_last, tolerance, &get_point_cell< T, dimension >, 0 );
+            }
+
+            if ( pass == pre_pass::radial_distance )
+            {
+                return ( T* ) simplify_radial_douglas_peucker< T, dimension, Kernel >( reinterpret_cast< vec * >( first ), vector_last, tolerance, scratch );
+            }
+            else
+            {
+                return ( T* ) simplify_douglas_peucker< T, dimension, Kernel >( reinterpret_cast< vec * >( first ), vector_last, tolerance, scratch );
+            }
+        }
+
+        // The same with highest_quality choosing between no pre-pass and the radial distance one.
+
+        template< class T, std::size_t dimension, class Kernel = distance_kernel< T, dimension > >
+        T * simplify(
+            T * const first,
+            T * const last,
+            const T tolerance = static_cast< T >( 1 ),
+            const bool highest_quality = false
+            )
+        {
+            return simplify< T, dimension, Kernel >( first, last, tolerance, highest_quality ? pre_pass::none : pre_pass::radial_distance );
+        }
+
+        // Counterpart of simplify on vect storage with fixed-capacity work tables, which can run in
+        // constant expressions from C++14 on, to simplify built-in shapes at compile time. The result
+        // is the same as simplify for float and double.
+
+        template< class T, std::size_t dimension, std::size_t capacity, class Statistics >
+        SIMPLIFY_CONSTEXPR14 vect< T, dimension > * simplify(
+            vect< T, dimension > * const first,
+            vect< T, dimension > * const last,
+            const T tolerance,
+            const bool highest_quality,
+            fixed_douglas_peucker_scratch< vect< T, dimension > *, capacity, Statistics > & scratch
+            )
+        {
+            static_assert( std::is_floating_point< T >::value, "T is not a floating point type" );
+
+            typedef distance_kernel< T, dimension > kernel;
+
+            if ( highest_quality )
+            {
+                return ::simplify::simplify_douglas_peucker( first, last, tolerance, &kernel::get_point_segment_square_distance, scratch );
+            }
+            else
+            {
+                return ::simplify::simplify_radial_douglas_peucker( first, last, tolerance, &kernel::get_point_segment_square_distance, &kernel::get_point_point_square_distance, scratch );
+            }
+        }
+
+        // Square of the first eccentricity of the WGS 84 ellipsoid.
+
+        constexpr double get_eccentricity_square()
+        {
+            return ( 1.0 / 298.257223563 ) * ( 2.0 - 1.0 / 298.257223563 );
+        }
+
+        // WGS 84 earth-centred, earth-fixed position in metres of a point of the ellipsoid surface.
+
+        inline vect< double, 3 > get_earth_centered_position(
+            const double longitude,
+            const double latitude
+            )
+        {
+            const double semi_major_axis = 6378137.0;
+            const double eccentricity_square = get_eccentricity_square();
+            const double radian_per_degree = 3.14159265358979323846 / 180.0;
+            const double sin_latitude = std::sin( latitude * radian_per_degree );
+            const double cos_latitude = std::cos( latitude * radian_per_degree );
+            const double prime_vertical_radius = semi_major_axis / std::sqrt( 1.0 - eccentricity_square * sin_latitude * sin_latitude );
+
+            return vect< double, 3 > { {
+                prime_vertical_radius * cos_latitude * std::cos( longitude * radian_per_degree ),
+                prime_vertical_radius * cos_latitude * std::sin( longitude * radian_per_degree ),
+                prime_vertical_radius * ( 1.0 - eccentricity_square ) * sin_latitude
+                } };
+        }
+
+        // Simplifies in place indices of the points of position_table, returning the end of the kept
+        // indices, for inputs whose points cannot be moved as vects. Distances are in T, so T is a
+        // floating point type.
+
+        template< class T, std::size_t dimension >
+        std::size_t * simplify_indices(
+            std::size_t * const first,
+            std::size_t * const last,
+            const vect< T, dimension > * const position_table,
+            const T tolerance,
+            const bool highest_quality
+            )
+        {
+            static_assert( std::is_floating_point< T >::value, "T is not a floating point type" );
+
+            typedef distance_kernel< T, dimension > kernel;
+
+            auto get_point_point_square_distance = [ position_table ]( const std::size_t first_index, const std::size_t second_index )
+            {
+                return kernel::get_point_point_square_distance( position_table[ first_index ], position_table[ second_index ] );
+            };
+
+            auto get_point_segment_square_distance = [ position_table ]( const std::size_t candidate_index, const std::size_t start_index, const std::size_t end_index )
+            {
+                return kernel::get_point_segment_square_distance( position_table[ candidate_index ], position_table[ start_index ], position_table[ end_index ] );
+            };
+
+            douglas_peucker_scratch< std::size_t * > scratch;
+
+            if ( highest_quality )
+            {
+                return ::simplify::simplify_douglas_peucker( first, last, tolerance, get_point_segment_square_distance, scratch );
+            }
+            else
+            {
+                return ::simplify::simplify_radial_douglas_peucker( first, last, tolerance, get_point_segment_square_distance, get_point_point_square_distance, scratch );
+            }
+        }
+
+        // Largest distance from the points of a polyline to its simplification, see
+        // get_max_deviation, and the index of the first point where it occurs.
+
+        template< class Real >
+        struct deviation
+        {
+            Real square_distance;
+            std::size_t index;
+        };
+
+        // Writes the squared distances from the count points of block to the segment from start to
+        // end. The projection parameters are clamped with selects and stored before the distances
+        // are measured, so that both loops stay branch-free and the compiler vectorizes them;
+        // called with a constant count, they also vectorize under the cheaper cost model of -O2.
+
+        template< class Real, class T, std::size_t dimension >
+        inline void get_block_square_distances(
+            const vect< T, dimension > * const block,
+            const std::size_t count,
+            const vect< Real, dimension > & start,
+            const vect< Real, dimension > & end,
+            const Real inverse_square_length,
+            Real * const t_table,
+            Real * const square_distance_table
+            )
+        {
+            for ( std::size_t i = 0; i < count; ++i )
+            {
+                const Real projection = difference_dot( vect_cast< Real >( block[ i ] ), start, end, start ) * inverse_square_length;
+                const Real clamped_projection = projection > Real( 0 ) ? projection : Real( 0 );
+
+                t_table[ i ] = clamped_projection < Real( 1 ) ? clamped_projection : Real( 1 );
+            }
+
+            for ( std::size_t i = 0; i < count; ++i )
+            {
+                square_distance_table[ i ] = unrolled< 0, dimension >::residual_square_distance( vect_cast< Real >( block[ i ] ), start, end, t_table[ i ], Real( 0 ) );
+            }
+        }
+
+        // Updates maximum with the points of [ first_index, last_index ) against the segment that
+        // replaced them. The distances are computed a block at a time, then the block is only
+        // searched when it beats maximum.
+
+        template< class Real, class T, std::size_t dimension >
+        void update_max_deviation(
+            const vect< T, dimension > * const points,
+            const std::size_t first_index,
+            const std::size_t last_index,
+            const vect< T, dimension > & segment_start,
+            const vect< T, dimension > & segment_end,
+            deviation< Real > & maximum
+            )
+        {
+            const std::size_t block_size = 16;
+            const vect< Real, dimension > start = vect_cast< Real >( segment_start ), end = vect_cast< Real >( segment_end );
+            const Real square_length = difference_dot( end, start, end, start );
+            const Real inverse_square_length = square_length > 0 ? 1 / square_length : 0;
+            Real t_table[ block_size ], square_distance_table[ block_size ];
+
+            for ( std::size_t block_first = first_index; block_first < last_index; block_first += block_size )
+            {
+                const std::size_t block_count = std::min( block_size, last_index - block_first );
+                const vect< T, dimension > * const block = points + block_first;
+
+                if ( block_count == block_size )
+                {
+                    get_block_square_distances( block, block_size, start, end, inverse_square_length, t_table, square_distance_table );
+                }
+                else
+                {
+                    get_block_square_distances( block, block_count, start, end, inverse_square_length, t_table, square_distance_table );
+                }
+
+                const Real * const block_maximum_it = std::max_element( square_distance_table, square_distance_table + block_count );
+
+                if ( *block_maximum_it > maximum.square_distance )
+                {
+                    maximum.square_distance = *block_maximum_it;
+                    maximum.index = block_first + ( block_maximum_it - square_distance_table );
+                }
+            }
+        }
+
+        // Verifies a simplification in O(n): walks the points of a polyline and the sorted indices
+        // of the kept points together, measuring each dropped point against the output segment that
+        // replaced it, which is what the Douglas-Peucker tolerance bounds. The result also bounds the
+        // Hausdorff distance between the polyline and its simplification. Distances are computed in
+        // T for floating point types and in double otherwise, independently of the kernels. The kept
+        // indices include both ends of the polyline.
+
+        template< class T, std::size_t dimension, class Real = typename std::conditional< std::is_floating_point< T >::value, T, double >::type >
+        deviation< Real > get_max_deviation(
+            const vect< T, dimension > * const points,
+            const std::size_t * const kept_first,
+            const std::size_t * const kept_last
+            )
+        {
+            deviation< Real > maximum { 0, kept_first != kept_last ? *kept_first : 0 };
+
+            for ( const std::size_t * it = kept_first; kept_last - it >= 2; ++it )
+            {
+                update_max_deviation( points, it[ 0 ] + 1, it[ 1 ], points[ it[ 0 ] ], points[ it[ 1 ] ], maximum );
+            }
+
+            return maximum;
+        }
+
+        // The same for the kept points themselves, as returned by the engines, matched in order
+        // against a copy of the original points. Indices are in [ first, last ). Each kept point is
+        // matched to the first equal point after the previous match, so the polyline must not
+        // revisit the coordinates of a kept point between two kept points, as a self-touching
+        // outline can; otherwise the segments are misplaced and the result is meaningless. Such
+        // inputs are verified with the indices returned by simplify_indices and the overload above.
+        // A kept point with no match after the previous one is reported as an infinite distance at
+        // index last - first, so that it cannot pass for a small deviation.
+
+        template< class T, std::size_t dimension, class Real = typename std::conditional< std::is_floating_point< T >::value, T, double >::type >
+        deviation< Real > get_max_deviation(
+            const vect< T, dimension > * const first,
+            const vect< T, dimension > * const last,
+            const vect< T, dimension > * const output_first,
+            const vect< T, dimension > * const output_last
+            )
+        {
+            deviation< Real > maximum { 0, 0 };
+            std::size_t segment_first_index = 0;
+
+            if ( output_last - output_first < 2 )
+            {
+                return maximum;
+            }
+
+            for ( const vect< T, dimension > * kept_it = output_first + 1; kept_it != output_last; ++kept_it )
+            {
+                std::size_t segment_last_index = segment_first_index + 1;
+
+                while ( segment_last_index + 1 < std::size_t( last - first ) && !( first[ segment_last_index ] == *kept_it ) )
+                {
+                    ++segment_last_index;
+                }
+
+                if ( segment_last_index >= std::size_t( last - first ) || !( first[ segment_last_index ] == *kept_it ) )
+                {
+                    return deviation< Real > { std::numeric_limits< Real >::infinity(), std::size_t( last - first ) };
+                }
+
+                update_max_deviation( first, segment_first_index + 1, segment_last_index, kept_it[ -1 ], *kept_it, maximum );
+                segment_first_index = segment_last_index;
+            }
+
+            return maximum;
+        }
+
+        // Simplifies polylines of ( longitude, latitude ) degrees with a tolerance in metres. Each
+        // point is projected once, then measured with the planar kernel, so the trigonometry is not
+        // paid again on every distance evaluation:
+        // - by default, onto the plane tangent to the ellipsoid at the centre of the polyline, which
+        //   shortens distances by less than 0.01% within 90 km of the centre;
+        // - with use_earth_centered, to earth-centred 3D coordinates, for tracks too long for one
+        //   plane. Segments are then straight chords below the surface, so points along a long
+        //   segment measure up to its length^2 / ( 8 * earth radius ) farther: the tolerance still
+        //   holds, but fewer points may be dropped.
+        // As with simplify, first to last holds whole points: an even number of values.
+
+        template< class T >
+        T * simplify_lon_lat(
+            T * const first,
+            T * const last,
+            const double tolerance,
+            const bool highest_quality = false,
+            const bool use_earth_centered = false
+            )
+        {
+            static_assert( std::is_floating_point< T >::value, "T is not a floating point type" );
+
+            const std::size_t point_count = ( last - first ) / 2;
+
+            if ( point_count <= 2 )
+            {
+                return last;
             }
-            else if ( t > 1.0 )
+
+            std::vector< vect< double, 3 > > earth_centered_table( point_count );
+            std::vector< std::size_t > index_table( point_count );
+            vect< double, 3 > centre { { 0.0, 0.0, 0.0 } };
+
+            for ( std::size_t i = 0; i < point_count; ++i )
             {
-                return get_point_point_square_distance< T >( candidate, segment_end );
+                earth_centered_table[ i ] = get_earth_centered_position( first[ 2 * i ], first[ 2 * i + 1 ] );
+                index_table[ i ] = i;
+
+                for ( std::size_t j = 0; j < 3; ++j )
+                {
+                    centre.values[ j ] += earth_centered_table[ i ].values[ j ];
+                }
+            }
+
+            std::size_t * kept_last;
+
+            if ( use_earth_centered )
+            {
+                kept_last = simplify_indices( index_table.data(), index_table.data() + point_count, earth_centered_table.data(), tolerance, highest_quality );
             }
             else
             {
-                const V projection = lerp( segment_start, segment_end, t );
+                const double centre_longitude = std::atan2( centre.values[ 1 ], centre.values[ 0 ] );
+                // The ellipsoid normal at ( x, y, z ) is along ( x, y, z / ( 1 - e^2 ) ), which gives the
+                // geodetic latitude of the centre rather than its geocentric one.
+
+                const double centre_latitude = std::atan2( centre.values[ 2 ] / ( 1.0 - get_eccentricity_square() ), std::hypot( centre.values[ 0 ], centre.values[ 1 ] ) );
+                const vect< double, 3 > east { { -std::sin( centre_longitude ), std::cos( centre_longitude ), 0.0 } };
+                const vect< double, 3 > north { {
+                    -std::sin( centre_latitude ) * std::cos( centre_longitude ),
+                    -std::sin( centre_latitude ) * std::sin( centre_longitude ),
+                    std::cos( centre_latitude )
+                    } };
+                std::vector< vect< double, 2 > > tangent_table( point_count );
+
+                for ( std::size_t i = 0; i < point_count; ++i )
+                {
+                    tangent_table[ i ] = vect< double, 2 > { { dot( earth_centered_table[ i ], east ), dot( earth_centered_table[ i ], north ) } };
+                }
 
-                return get_point_point_square_distance< T >( candidate, projection );
+                kept_last = simplify_indices( index_table.data(), index_table.data() + point_count, tangent_table.data(), tolerance, highest_quality );
             }
+
+            T * write_it = first;
+
+            for ( const std::size_t * it = index_table.data(); it != kept_last; ++it )
+            {
+                *write_it++ = first[ 2 * *it ];
+                *write_it++ = first[ 2 * *it + 1 ];
+            }
+
+            return write_it;
         }
 
+        // Simplifies vertices stride bytes apart, whose first dimension values of type T are their
+        // position, as in interleaved vertex buffers. Positions are gathered once so that the scans
+        // do not stride over the other attributes, and whole vertices are then compacted in place.
+        // The gather costs a copy of the positions and a table of indices, vertex_count of each,
+        // on top of the vertices. Returns the kept vertex count, or 0 without touching the
+        // vertices when stride is smaller than a position.
+
         template< class T, std::size_t dimension >
-        T * simplify(
-            T * const first,
-            T * const last,
+        std::size_t simplify_strided(
+            void * const vertices,
+            const std::size_t vertex_count,
+            const std::size_t stride,
             const T tolerance = static_cast< T >( 1 ),
             const bool highest_quality = false
             )
+        {
+            if ( stride < sizeof( vect< T, dimension > ) )
+            {
+                return 0;
+            }
+            else if ( vertex_count <= 2 )
+            {
+                return vertex_count;
+            }
+
+            char * const bytes = static_cast< char * >( vertices );
+            std::vector< vect< T, dimension > > position_table( vertex_count );
+            std::vector< std::size_t > index_table( vertex_count );
+
+            for ( std::size_t i = 0; i < vertex_count; ++i )
+            {
+                std::memcpy( &position_table[ i ], bytes + i * stride, sizeof( vect< T, dimension > ) );
+                index_table[ i ] = i;
+            }
+
+            const std::size_t * kept_last = simplify_indices( index_table.data(), index_table.data() + vertex_count, position_table.data(), tolerance, highest_quality );
+            std::size_t kept_count = 0;
+
+            for ( const std::size_t * it = index_table.data(); it != kept_last; ++it, ++kept_count )
+            {
+                if ( *it != kept_count )
+                {
+                    std::memcpy( bytes + kept_count * stride, bytes + *it * stride, stride );
+                }
+            }
+
+            return kept_count;
+        }
+
+        // Calls function( index ) for every index below item_count on thread_count threads (0 for one
+        // per core). Each thread runs its own copy of function, which can therefore hold scratch.
+
+        template< class Function >
+        void parallel_for(
+            const std::size_t item_count,
+            std::size_t thread_count,
+            const Function & function
+            )
+        {
+            const std::size_t grain = 64;
+            std::atomic< std::size_t > next_item( 0 );
+
+            auto run = [ &next_item, item_count, grain ]( Function thread_function )
+            {
+                for ( ;; )
+                {
+                    const std::size_t first_item = next_item.fetch_add( grain );
+
+                    if ( first_item >= item_count )
+                    {
+                        break;
+                    }
+
+                    const std::size_t last_item = std::min( first_item + grain, item_count );
+
+                    for ( std::size_t item = first_item; item < last_item; ++item )
+                    {
+                        thread_function( item );
+                    }
+                }
+            };
+
+            if ( thread_count == 0 )
+            {
+                thread_count = std::max( 1u, std::thread::hardware_concurrency() );
+            }
+
+            thread_count = std::min( thread_count, ( item_count + grain - 1 ) / grain );
+
+            std::vector< std::thread > thread_table;
+
+            for ( std::size_t thread_index = 1; thread_index < thread_count; ++thread_index )
+            {
+                thread_table.emplace_back( run, function );
+            }
+
+            run( function );
+
+            for ( auto & thread : thread_table )
+            {
+                thread.join();
+            }
+        }
+
+        // Writes one keep level per point of [ first, last ), see simplify_douglas_peucker_levels.
+
+        template< class T, std::size_t dimension >
+        unsigned char * simplify_levels(
+            const T * const first,
+            const T * const last,
+            const T * const tolerances,
+            const std::size_t tolerance_count,
+            unsigned char * const levels
+            )
         {
             static_assert( std::is_arithmetic< T >::value, "T is not an arithmetic type" );
 
             typedef vect< T, dimension > vec;
 
-            if ( highest_quality )
+            return ::simplify::simplify_douglas_peucker_levels(
+                reinterpret_cast< const vec * >( first ),
+                reinterpret_cast< const vec * >( last ),
+                tolerances,
+                tolerances + tolerance_count,
+                levels,
+                &get_point_segment_square_distance< T, vec >
+                );
+        }
+
+        template< class T, std::size_t dimension, class Kernel, class GetTolerance >
+        T * simplify_batch_features(
+            const T * const coordinates,
+            const std::size_t * const offsets,
+            const std::size_t feature_count,
+            std::size_t * const new_offsets,
+            T * const output,
+            GetTolerance get_tolerance,
+            const bool highest_quality,
+            const std::size_t thread_count
+            )
+        {
+            static_assert( std::is_arithmetic< T >::value, "T is not an arithmetic type" );
+
+            typedef vect< T, dimension > vec;
+
+            const vec * const source = reinterpret_cast< const vec * >( coordinates );
+            vec * const destination = reinterpret_cast< vec * >( output );
+
+            std::vector< std::size_t > kept_count_table( feature_count );
+            douglas_peucker_scratch< vec * > scratch;
+
+            parallel_for( feature_count, thread_count, [ &, scratch ]( std::size_t feature ) mutable
             {
-                return ( T* ) ::simplify::simplify(
-                    reinterpret_cast< vec * >( first ),
-                    reinterpret_cast< vec * >( last ),
-                    tolerance,
-                    &get_point_segment_square_distance< T, vec >
-                    );
+                vec * first = destination + offsets[ feature ];
+                vec * last = destination + offsets[ feature + 1 ];
+                const T tolerance = get_tolerance( feature );
+
+                if ( source != destination )
+                {
+                    std::copy( source + offsets[ feature ], source + offsets[ feature + 1 ], first );
+                }
+
+                if ( highest_quality )
+                {
+                    last = simplify_douglas_peucker< T, dimension, Kernel >( first, last, tolerance, scratch );
+                }
+                else
+                {
+                    last = simplify_radial_douglas_peucker< T, dimension, Kernel >( first, last, tolerance, scratch );
+                }
+                kept_count_table[ feature ] = static_cast< std::size_t >( last - first );
+            } );
+
+            // Kept points only move towards the front, so the compaction is a forward pass. offsets is
+            // read ahead of new_offsets being written, as both may be the same table.
+
+            std::size_t feature_first = feature_count ? offsets[ 0 ] : 0, write_index = 0;
+
+            new_offsets[ 0 ] = 0;
+
+            for ( std::size_t feature = 0; feature < feature_count; ++feature )
+            {
+                const std::size_t next_feature_first = offsets[ feature + 1 ];
+                vec * const first = destination + feature_first;
+
+                if ( write_index != feature_first )
+                {
+                    std::move( first, first + kept_count_table[ feature ], destination + write_index );
+                }
+
+                write_index += kept_count_table[ feature ];
+                new_offsets[ feature + 1 ] = write_index;
+                feature_first = next_feature_first;
             }
-            else
+
+            return output + write_index * dimension;
+        }
+
+        // Simplifies feature_count polylines stored back to back, feature i being the points from
+        // offsets[ i ] to offsets[ i + 1 ] (offsets count points, not coordinates). Features are
+        // simplified in parallel on thread_count threads (0 for one per core), then compacted in
+        // order into output, which is either coordinates itself or a buffer of the same size.
+        // new_offsets receives feature_count + 1 offsets into output and may be offsets itself.
+        // Returns the end of the compacted coordinates.
+
+        template< class T, std::size_t dimension, class Kernel = distance_kernel< T, dimension > >
+        T * simplify_batch(
+            const T * const coordinates,
+            const std::size_t * const offsets,
+            const std::size_t feature_count,
+            std::size_t * const new_offsets,
+            T * const output,
+            const T tolerance = static_cast< T >( 1 ),
+            const bool highest_quality = false,
+            const std::size_t thread_count = 0
+            )
+        {
+            return simplify_batch_features< T, dimension, Kernel >(
+                coordinates,
+                offsets,
+                feature_count,
+                new_offsets,
+                output,
+                [ tolerance ]( std::size_t ) { return tolerance; },
+                highest_quality,
+                thread_count
+                );
+        }
+
+        // Same as above with one tolerance per feature.
+
+        template< class T, std::size_t dimension, class Kernel = distance_kernel< T, dimension > >
+        T * simplify_batch(
+            const T * const coordinates,
+            const std::size_t * const offsets,
+            const std::size_t feature_count,
+            std::size_t * const new_offsets,
+            T * const output,
+            const T * const tolerances,
+            const bool highest_quality = false,
+            const std::size_t thread_count = 0
+            )
+        {
+            return simplify_batch_features< T, dimension, Kernel >(
+                coordinates,
+                offsets,
+                feature_count,
+                new_offsets,
+                output,
+                [ tolerances ]( std::size_t feature ) { return tolerances[ feature ]; },
+                highest_quality,
+                thread_count
+                );
+        }
+
+        template< class T, std::size_t dimension >
+        struct vect_hash
+        {
+            std::size_t operator()( const vect< T, dimension > & vector ) const
             {
-                return ( T* ) ::simplify::simplify(
-                    reinterpret_cast< vec * >( first ),
-                    reinterpret_cast< vec * >( last ),
-                    tolerance,
-                    &get_point_segment_square_distance< T, vec >,
-                    &get_point_point_square_distance< T, vec >
-                    );
+                std::size_t result = 0;
+
+                for ( std::size_t i = 0; i < dimension; ++i )
+                {
+                    result = result * 31 + std::hash< T >()( vector.values[ i ] );
+                }
+
+                return result;
+            }
+        };
+
+        template< class T, std::size_t dimension >
+        bool lexicographical_less(
+            const vect< T, dimension > & first,
+            const vect< T, dimension > & second
+            )
+        {
+            return std::lexicographical_compare( first.values, first.values + dimension, second.values, second.values + dimension );
+        }
+
+        // Simplifies a polygon coverage without opening gaps between neighbours. Rings are stored back
+        // to back and explicitly closed (last point equal to the first), ring i being the points from
+        // offsets[ i ] to offsets[ i + 1 ]. Rings are cut into arcs at junctions, the vertices whose
+        // neighbours differ from one occurrence to another; an arc shared by several rings is found by
+        // hashing its vertex run, simplified once with fixed ends, and reused by each ring. Rebuilt
+        // rings start on their first junction, or on their lexicographically smallest vertex when
+        // they have none. Rings with fewer than four points are copied as is, and a ring whose arcs
+        // simplify to fewer than four points, as the single arc of a ring without junction does when
+        // it is reduced to its ends, keeps these arcs whole, in every ring sharing them. output,
+        // new_offsets and thread_count follow simplify_batch. Returns the end of the written
+        // coordinates.
+
+        template< class T, std::size_t dimension, class Kernel = distance_kernel< T, dimension > >
+        T * simplify_coverage(
+            const T * const coordinates,
+            const std::size_t * const offsets,
+            const std::size_t ring_count,
+            std::size_t * const new_offsets,
+            T * const output,
+            const T tolerance = static_cast< T >( 1 ),
+            const bool highest_quality = false,
+            const std::size_t thread_count = 0
+            )
+        {
+            static_assert( std::is_arithmetic< T >::value, "T is not an arithmetic type" );
+
+            typedef vect< T, dimension > vec;
+            typedef vect_hash< T, dimension > vec_hash;
+
+            struct vertex_neighbours
+            {
+                vec first, second;
+                bool is_junction;
+            };
+
+            struct arc_use
+            {
+                std::size_t arc_index;
+                bool is_reversed;
+            };
+
+            struct arc_source
+            {
+                std::size_t ring, first_index, last_index;
+                bool is_reversed;
+            };
+
+            const vec * const source = reinterpret_cast< const vec * >( coordinates );
+            auto is_simplified_ring = [ offsets ]( std::size_t ring ) { return offsets[ ring + 1 ] - offsets[ ring ] >= 4; };
+
+            std::unordered_map< vec, vertex_neighbours, vec_hash > vertex_table;
+
+            for ( std::size_t ring = 0; ring < ring_count; ++ring )
+            {
+                if ( !is_simplified_ring( ring ) )
+                {
+                    continue;
+                }
+
+                const vec * const ring_first = source + offsets[ ring ];
+                const std::size_t vertex_count = offsets[ ring + 1 ] - offsets[ ring ] - 1;
+
+                for ( std::size_t index = 0; index < vertex_count; ++index )
+                {
+                    vec previous = ring_first[ index == 0 ? vertex_count - 1 : index - 1 ];
+                    vec next = ring_first[ index + 1 == vertex_count ? 0 : index + 1 ];
+
+                    if ( lexicographical_less( next, previous ) )
+                    {
+                        std::swap( previous, next );
+                    }
+
+                    auto inserted = vertex_table.insert( std::make_pair( ring_first[ index ], vertex_neighbours { previous, next, false } ) );
+                    vertex_neighbours & neighbours = inserted.first->second;
+
+                    if ( !inserted.second && !( neighbours.first == previous && neighbours.second == next ) )
+                    {
+                        neighbours.is_junction = true;
+                    }
+                }
+            }
+
+            std::vector< std::vector< vec > > arc_table;
+            std::vector< arc_source > arc_source_table;
+            std::unordered_multimap< std::size_t, std::size_t > arc_index_table;
+            std::vector< std::vector< arc_use > > ring_arc_table( ring_count );
+            std::vector< vec > arc;
+
+            for ( std::size_t ring = 0; ring < ring_count; ++ring )
+            {
+                if ( !is_simplified_ring( ring ) )
+                {
+                    continue;
+                }
+
+                const vec * const ring_first = source + offsets[ ring ];
+                const std::size_t vertex_count = offsets[ ring + 1 ] - offsets[ ring ] - 1;
+                std::vector< std::size_t > junction_index_table;
+
+                for ( std::size_t index = 0; index < vertex_count; ++index )
+                {
+                    if ( vertex_table[ ring_first[ index ] ].is_junction )
+                    {
+                        junction_index_table.push_back( index );
+                    }
+                }
+
+                if ( junction_index_table.empty() )
+                {
+                    const std::size_t smallest_index = std::min_element( ring_first, ring_first + vertex_count, &lexicographical_less< T, dimension > ) - ring_first;
+
+                    vertex_table[ ring_first[ smallest_index ] ].is_junction = true;
+                    junction_index_table.push_back( smallest_index );
+                }
+
+                for ( std::size_t junction = 0; junction < junction_index_table.size(); ++junction )
+                {
+                    const std::size_t arc_first = junction_index_table[ junction ];
+                    const std::size_t arc_last = junction + 1 < junction_index_table.size() ? junction_index_table[ junction + 1 ] : junction_index_table.front() + vertex_count;
+
+                    arc.clear();
+
+                    for ( std::size_t index = arc_first; index <= arc_last; ++index )
+                    {
+                        arc.push_back( ring_first[ index % vertex_count ] );
+                    }
+
+                    const bool is_reversed = std::lexicographical_compare( arc.rbegin(), arc.rend(), arc.begin(), arc.end(), &lexicographical_less< T, dimension > );
+
+                    if ( is_reversed )
+                    {
+                        std::reverse( arc.begin(), arc.end() );
+                    }
+
+                    std::size_t arc_hash = 0;
+
+                    for ( const vec & vertex : arc )
+                    {
+                        arc_hash = arc_hash * 1099511628211u + vec_hash()( vertex );
+                    }
+
+                    auto candidates = arc_index_table.equal_range( arc_hash );
+                    auto found = std::find_if( candidates.first, candidates.second, [ & ]( const std::pair< const std::size_t, std::size_t > & candidate )
+                    {
+                        return arc_table[ candidate.second ].size() == arc.size() && std::equal( arc.begin(), arc.end(), arc_table[ candidate.second ].begin() );
+                    } );
+
+                    if ( found == candidates.second )
+                    {
+                        found = arc_index_table.insert( std::make_pair( arc_hash, arc_table.size() ) );
+                        arc_table.push_back( arc );
+                        arc_source_table.push_back( arc_source { ring, arc_first, arc_last, is_reversed } );
+                    }
+
+                    ring_arc_table[ ring ].push_back( arc_use { found->second, is_reversed } );
+                }
+            }
+
+            std::vector< std::size_t > arc_kept_count_table( arc_table.size() );
+            douglas_peucker_scratch< vec * > scratch;
+
+            parallel_for( arc_table.size(), thread_count, [ &, scratch ]( std::size_t arc_index ) mutable
+            {
+                vec * first = arc_table[ arc_index ].data();
+                vec * last = first + arc_table[ arc_index ].size();
+
+                if ( highest_quality )
+                {
+                    last = simplify_douglas_peucker< T, dimension, Kernel >( first, last, tolerance, scratch );
+                }
+                else
+                {
+                    last = simplify_radial_douglas_peucker< T, dimension, Kernel >( first, last, tolerance, scratch );
+                }
+                arc_kept_count_table[ arc_index ] = static_cast< std::size_t >( last - first );
+            } );
+
+            // Arcs are simplified in place, so the ones kept whole are read again from the ring they
+            // were found in. This only lengthens the other rings sharing them.
+
+            for ( std::size_t ring = 0; ring < ring_count; ++ring )
+            {
+                std::size_t point_count = 1;
+
+                for ( const arc_use & use : ring_arc_table[ ring ] )
+                {
+                    point_count += arc_kept_count_table[ use.arc_index ] - 1;
+                }
+
+                if ( ring_arc_table[ ring ].empty() || point_count >= 4 )
+                {
+                    continue;
+                }
+
+                for ( const arc_use & use : ring_arc_table[ ring ] )
+                {
+                    const arc_source & origin = arc_source_table[ use.arc_index ];
+                    const vec * const ring_first = source + offsets[ origin.ring ];
+                    const std::size_t vertex_count = offsets[ origin.ring + 1 ] - offsets[ origin.ring ] - 1;
+                    std::vector< vec > & whole_arc = arc_table[ use.arc_index ];
+
+                    for ( std::size_t index = origin.first_index; index <= origin.last_index; ++index )
+                    {
+                        whole_arc[ index - origin.first_index ] = ring_first[ index % vertex_count ];
+                    }
+
+                    if ( origin.is_reversed )
+                    {
+                        std::reverse( whole_arc.begin(), whole_arc.end() );
+                    }
+
+                    arc_kept_count_table[ use.arc_index ] = whole_arc.size();
+                }
+            }
+
+            // Every ring is rebuilt from data held outside of coordinates or ahead of the write
+            // position, so output may be coordinates itself. offsets is read ahead of new_offsets
+            // being written, as both may be the same table.
+
+            vec * const destination = reinterpret_cast< vec * >( output );
+            std::size_t source_first = ring_count ? offsets[ 0 ] : 0, write_index = 0;
+
+            new_offsets[ 0 ] = 0;
+
+            for ( std::size_t ring = 0; ring < ring_count; ++ring )
+            {
+                const std::size_t next_source_first = offsets[ ring + 1 ];
+
+                if ( ring_arc_table[ ring ].empty() )
+                {
+                    std::move( source + source_first, source + next_source_first, destination + write_index );
+                    write_index += next_source_first - source_first;
+                }
+                else
+                {
+                    for ( const arc_use & use : ring_arc_table[ ring ] )
+                    {
+                        const vec * const arc_first = arc_table[ use.arc_index ].data();
+                        const std::size_t arc_size = arc_kept_count_table[ use.arc_index ];
+
+                        if ( use.is_reversed )
+                        {
+                            std::reverse_copy( arc_first + 1, arc_first + arc_size, destination + write_index );
+                        }
+                        else
+                        {
+                            std::copy( arc_first, arc_first + arc_size - 1, destination + write_index );
+                        }
+
+                        write_index += arc_size - 1;
+                    }
+
+                    destination[ write_index ] = destination[ new_offsets[ ring ] ];
+                    ++write_index;
+                }
+
+                new_offsets[ ring + 1 ] = write_index;
+                source_first = next_source_first;
             }
+
+            return output + write_index * dimension;
         }
     }
 
+    #if defined( __SIZEOF_INT128__ )
+    #define simplify2s helpers::simplify< std::int16_t, 2 >
+    #endif
     #define simplify2i helpers::simplify< int, 2 >
     #define simplify3i helpers::simplify< int, 3 >
     #define simplify2f helpers::simplify< float, 2 >
@@ -0,0 +1,425 @@
+#include "simplify.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Runs each simplifier of simplify.hpp on a corpus of polylines and reports, per engine, the time
+// for the whole corpus, the throughput, the points kept, the maximum segment deviation and the
+// area change, as a table on the standard output and optionally as CSV:
+//
+// engine,seconds,points_per_second,input_point_count,output_point_count,kept_ratio,max_segment_deviation,area_change_ratio
+//
+// The maximum segment deviation, from helpers::get_max_deviation, measures each input point against
+// the output segment between the kept points around it, the kept points being matched to the input
+// by equality. It is an upper bound of the Hausdorff distance between input and output, not the
+// distance itself, and is what the Douglas-Peucker tolerance bounds. The area change is the sum
+// over the polylines of the change of the area enclosed by each polyline and its closing segment,
+// in the first two coordinates, over the sum of the input areas.
+//
+// simplify_douglas_peucker is helpers::simplify, which guards against degenerate splits, and
+// generic_douglas_peucker the generic engine with the same kernel and no guard. The precision
+// engine accumulates float coordinates in double and double ones in float. simplify_levels
+// computes the levels for the one tolerance, then keeps the level 0 points. simplify_batch
+// simplifies the whole corpus in one call on one thread per core, the other engines run on one
+// thread. Not compared: the exact integer kernels, as the corpus is float or double;
+// simplify_lon_lat, which takes degrees and a tolerance in metres; simplify_coverage, which needs
+// closed rings sharing edges; and simplify_out_of_core, a separate tool whose output is that of
+// simplify_douglas_peucker by construction.
+//
+// The corpus is a stream of polylines, each a little-endian uint64 point count followed by the
+// points as raw little-endian values, as read by simplify_pipeline.
+//
+// usage: simplify_compare -t float|double -d 2|3 [-e tolerance] [-s min_seconds] [-c csv_output] [input]
+
+#if defined( __BYTE_ORDER__ ) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+    #error "simplify_compare expects a little-endian host, point streams are read as is"
+#endif
+
+namespace
+{
+    struct options
+    {
+        std::string type { "float" };
+        std::size_t dimension { 2 };
+        double tolerance { 1.0 };
+        double min_seconds { 0.2 };
+        const char * input_path { nullptr };
+        const char * csv_path { nullptr };
+    };
+
+    // The polylines are stored end to end, offset_table giving the first coordinate of each.
+
+    template< class T >
+    struct corpus
+    {
+        std::vector< T > coordinates;
+        std::vector< std::size_t > offset_table { 0 };
+    };
+
+    struct result
+    {
+        std::string engine;
+        double seconds;
+        std::size_t input_point_count, output_point_count;
+        double max_segment_deviation, area_change_ratio;
+    };
+
+    template< class T, std::size_t dimension >
+    bool read_corpus( std::FILE * input, corpus< T > & polylines )
+    {
+        std::uint64_t point_count;
+
+        while ( std::fread( &point_count, sizeof( point_count ), 1, input ) == 1 )
+        {
+            const std::size_t first = polylines.coordinates.size();
+
+            if ( point_count > ( polylines.coordinates.max_size() - first ) / dimension )
+            {
+                return false;
+            }
+
+            const std::size_t coordinate_count = static_cast< std::size_t >( point_count ) * dimension;
+
+            polylines.coordinates.resize( first + coordinate_count );
+
+            if ( std::fread( polylines.coordinates.data() + first, sizeof( T ), coordinate_count, input ) != coordinate_count )
+            {
+                return false;
+            }
+
+            polylines.offset_table.push_back( polylines.coordinates.size() );
+        }
+
+        return !std::ferror( input );
+    }
+
+    template< class T, std::size_t dimension >
+    double get_area( const T * first, const T * last )
+    {
+        double area = 0.0;
+
+        for ( const T * it = first; it != last; it += dimension )
+        {
+            const T * next = it + dimension == last ? first : it + dimension;
+
+            area += double( it[ 0 ] ) * double( next[ 1 ] ) - double( next[ 0 ] ) * double( it[ 1 ] );
+        }
+
+        return 0.5 * area;
+    }
+
+    // Simplifies copies of the corpus until min_seconds of passes were timed, then measures the
+    // output of the last pass against the input. simplify_corpus( work, first_table, last_table )
+    // simplifies the copy work and writes the coordinate range of each output polyline.
+
+    template< class T, std::size_t dimension, class SimplifyCorpus >
+    result measure_corpus( const options & opts, const char * engine, const corpus< T > & polylines, SimplifyCorpus simplify_corpus )
+    {
+        typedef ::simplify::helpers::vect< T, dimension > vec;
+
+        std::vector< T > work( polylines.coordinates.size() );
+        std::vector< std::size_t > first_table( polylines.offset_table.size() - 1 ), last_table( first_table.size() );
+        std::size_t pass_count = 0;
+        double seconds = 0.0;
+
+        while ( seconds < opts.min_seconds || pass_count == 0 )
+        {
+            std::copy( polylines.coordinates.begin(), polylines.coordinates.end(), work.begin() );
+
+            const auto start = std::chrono::steady_clock::now();
+
+            simplify_corpus( work.data(), first_table, last_table );
+
+            seconds += std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+            ++pass_count;
+        }
+
+        result current { engine, seconds / pass_count, polylines.coordinates.size() / dimension, 0, 0.0, 0.0 };
+        double input_area = 0.0, area_change = 0.0;
+
+        for ( std::size_t i = 0; i < last_table.size(); ++i )
+        {
+            const T * const input_first = polylines.coordinates.data() + polylines.offset_table[ i ];
+            const T * const input_last = polylines.coordinates.data() + polylines.offset_table[ i + 1 ];
+            const T * const output_first = work.data() + first_table[ i ];
+            const T * const output_last = work.data() + last_table[ i ];
+            const double area = get_area< T, dimension >( input_first, input_last );
+
+            current.output_point_count += static_cast< std::size_t >( output_last - output_first ) / dimension;
+            current.max_segment_deviation = std::max( current.max_segment_deviation, std::sqrt( double( ::simplify::helpers::get_max_deviation(
+                reinterpret_cast< const vec * >( input_first ),
+                reinterpret_cast< const vec * >( input_last ),
+                reinterpret_cast< const vec * >( output_first ),
+                reinterpret_cast< const vec * >( output_last )
+                ).square_distance ) ) );
+            input_area += std::abs( area );
+            area_change += std::abs( get_area< T, dimension >( output_first, output_last ) - area );
+        }
+
+        current.area_change_ratio = input_area > 0.0 ? area_change / input_area : 0.0;
+
+        return current;
+    }
+
+    // The same for an engine simplifying one polyline in place.
+
+    template< class T, std::size_t dimension, class Simplify >
+    result measure( const options & opts, const char * engine, const corpus< T > & polylines, Simplify simplify )
+    {
+        return measure_corpus< T, dimension >( opts, engine, polylines, [ & ]( T * work, std::vector< std::size_t > & first_table, std::vector< std::size_t > & last_table )
+        {
+            for ( std::size_t i = 0; i < last_table.size(); ++i )
+            {
+                first_table[ i ] = polylines.offset_table[ i ];
+                last_table[ i ] = static_cast< std::size_t >( simplify( work + polylines.offset_table[ i ], work + polylines.offset_table[ i + 1 ] ) - work );
+            }
+        } );
+    }
+
+    template< class T, std::size_t dimension >
+    int run( const options & opts, std::FILE * input, std::FILE * csv )
+    {
+        typedef ::simplify::helpers::vect< T, dimension > vec;
+
+        corpus< T > polylines;
+
+        if ( !read_corpus< T, dimension >( input, polylines ) )
+        {
+            std::fprintf( stderr, "simplify_compare: truncated or unreadable input\n" );
+
+            return EXIT_FAILURE;
+        }
+
+        typedef typename std::conditional< std::is_same< T, float >::value, double, float >::type other_precision;
+
+        const T tolerance = static_cast< T >( opts.tolerance );
+        const std::size_t feature_count = polylines.offset_table.size() - 1;
+        std::vector< std::size_t > point_offset_table, new_offset_table( feature_count + 1 );
+        std::size_t max_point_count = 0;
+        std::vector< result > result_table;
+
+        for ( std::size_t offset : polylines.offset_table )
+        {
+            point_offset_table.push_back( offset / dimension );
+        }
+
+        for ( std::size_t i = 0; i < feature_count; ++i )
+        {
+            max_point_count = std::max( max_point_count, point_offset_table[ i + 1 ] - point_offset_table[ i ] );
+        }
+
+        std::vector< unsigned char > level_table( max_point_count );
+
+        result_table.push_back( measure< T, dimension >( opts, "remove_redundant_points", polylines, [ & ]( T * first, T * last )
+        {
+            return ( T * ) ::simplify::helpers::remove_redundant_points( reinterpret_cast< vec * >( first ), reinterpret_cast< vec * >( last ) );
+        } ) );
+
+        result_table.push_back( measure< T, dimension >( opts, "simplify_grid_snap", polylines, [ & ]( T * first, T * last )
+        {
+            return ( T * ) ::simplify::simplify_grid_snap( reinterpret_cast< vec * >( first ), reinterpret_cast< vec * >( last ), tolerance, &::simplify::helpers::get_point_cell< T, dimension > );
+        } ) );
+
+        result_table.push_back( measure< T, dimension >( opts, "simplify_radial_distance", polylines, [ & ]( T * first, T * last )
+        {
+            return ( T * ) ::simplify::helpers::simplify_radial_distance( reinterpret_cast< vec * >( first ), reinterpret_cast< vec * >( last ), tolerance );
+        } ) );
+
+        result_table.push_back( measure< T, dimension >( opts, "simplify_douglas_peucker", polylines, [ & ]( T * first, T * last )
+        {
+            return ::simplify::helpers::simplify< T, dimension >( first, last, tolerance, true );
+        } ) );
+
+        result_table.push_back( measure< T, dimension >( opts, "generic_douglas_peucker", polylines, [ & ]( T * first, T * last )
+        {
+            return ( T * ) ::simplify::simplify_douglas_peucker( reinterpret_cast< vec * >( first ), reinterpret_cast< vec * >( last ), tolerance, &::simplify::helpers::distance_kernel< T, dimension >::get_point_segment_square_distance );
+        } ) );
+
+        result_table.push_back( measure< T, dimension >( opts, "simplify_radial_douglas_peucker", polylines, [ & ]( T * first, T * last )
+        {
+            return ::simplify::helpers::simplify< T, dimension >( first, last, tolerance, false );
+        } ) );
+
+        result_table.push_back( measure< T, dimension >( opts, "simplify_grid_snap_douglas_peucker", polylines, [ & ]( T * first, T * last )
+        {
+            return ::simplify::helpers::simplify< T, dimension >( first, last, tolerance, ::simplify::helpers::pre_pass::grid_snap );
+        } ) );
+
+        result_table.push_back( measure< T, dimension >( opts, "simplify_redundant_radial_douglas_peucker", polylines, [ & ]( T * first, T * last )
+        {
+            return ::simplify::helpers::simplify< T, dimension >( first, last, tolerance, ::simplify::helpers::pre_pass::radial_distance, ::simplify::helpers::redundant_points::remove );
+        } ) );
+
+        result_table.push_back( measure< T, dimension >( opts, "simplify_promoted_radial_douglas_peucker", polylines, [ & ]( T * first, T * last )
+        {
+            return ::simplify::helpers::simplify< T, dimension, ::simplify::helpers::promoted_distance_kernel< T, dimension > >( first, last, tolerance, false );
+        } ) );
+
+        result_table.push_back( measure< T, dimension >( opts, "simplify_precision_radial_douglas_peucker", polylines, [ & ]( T * first, T * last )
+        {
+            return ::simplify::helpers::simplify< T, dimension, ::simplify::helpers::precision_kernel< T, dimension, other_precision > >( first, last, tolerance, false );
+        } ) );
+
+        result_table.push_back( measure< T, dimension >( opts, "simplify_levels", polylines, [ & ]( T * first, T * last )
+        {
+            const std::size_t point_count = static_cast< std::size_t >( last - first ) / dimension;
+            T * write_it = first;
+
+            ::simplify::helpers::simplify_levels< T, dimension >( first, last, &tolerance, 1, level_table.data() );
+
+            for ( std::size_t i = 0; i < point_count; ++i )
+            {
+                if ( level_table[ i ] == 0 )
+                {
+                    write_it = std::copy( first + i * dimension, first + ( i + 1 ) * dimension, write_it );
+                }
+            }
+
+            return write_it;
+        } ) );
+
+        result_table.push_back( measure_corpus< T, dimension >( opts, "simplify_batch", polylines, [ & ]( T * work, std::vector< std::size_t > & first_table, std::vector< std::size_t > & last_table )
+        {
+            ::simplify::helpers::simplify_batch< T, dimension >( work, point_offset_table.data(), feature_count, new_offset_table.data(), work, tolerance, false );
+
+            for ( std::size_t i = 0; i < feature_count; ++i )
+            {
+                first_table[ i ] = new_offset_table[ i ] * dimension;
+                last_table[ i ] = new_offset_table[ i + 1 ] * dimension;
+            }
+        } ) );
+
+        std::printf( "%zu polylines, %zu points, tolerance %g\n\n", polylines.offset_table.size() - 1, polylines.coordinates.size() / dimension, opts.tolerance );
+        std::printf( "%-42s %12s %16s %12s %10s %22s %12s\n", "engine", "seconds", "points/s", "output", "kept", "max segment deviation", "area change" );
+
+        for ( const result & current : result_table )
+        {
+            const double kept_ratio = current.input_point_count ? double( current.output_point_count ) / current.input_point_count : 0.0;
+
+            std::printf(
+                "%-42s %12.6f %16.0f %12zu %9.2f%% %22.6g %11.4f%%\n",
+                current.engine.c_str(),
+                current.seconds,
+                current.input_point_count / current.seconds,
+                current.output_point_count,
+                100.0 * kept_ratio,
+                current.max_segment_deviation,
+                100.0 * current.area_change_ratio
+                );
+
+            if ( csv )
+            {
+                std::fprintf(
+                    csv,
+                    "%s,%.9f,%.0f,%zu,%zu,%.6f,%.9g,%.9g\n",
+                    current.engine.c_str(),
+                    current.seconds,
+                    current.input_point_count / current.seconds,
+                    current.input_point_count,
+                    current.output_point_count,
+                    kept_ratio,
+                    current.max_segment_deviation,
+                    current.area_change_ratio
+                    );
+            }
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    int usage()
+    {
+        std::fprintf( stderr, "usage: simplify_compare -t float|double -d 2|3 [-e tolerance] [-s min_seconds] [-c csv_output] [input]\n" );
+
+        return EXIT_FAILURE;
+    }
+}
+
+int main( int argc, char ** argv )
+{
+    options opts;
+    int argument_index = 1;
+
+    for ( ; argument_index + 1 < argc && argv[ argument_index ][ 0 ] == '-' && argv[ argument_index ][ 1 ]; argument_index += 2 )
+    {
+        const std::string flag = argv[ argument_index ];
+        const char * value = argv[ argument_index + 1 ];
+
+        if ( flag == "-t" )
+        {
+            opts.type = value;
+        }
+        else if ( flag == "-d" )
+        {
+            opts.dimension = std::strtoul( value, nullptr, 10 );
+        }
+        else if ( flag == "-e" )
+        {
+            opts.tolerance = std::strtod( value, nullptr );
+        }
+        else if ( flag == "-s" )
+        {
+            opts.min_seconds = std::strtod( value, nullptr );
+        }
+        else if ( flag == "-c" )
+        {
+            opts.csv_path = value;
+        }
+        else
+        {
+            return usage();
+        }
+    }
+
+    if ( argc - argument_index > 1 || ( argument_index < argc && argv[ argument_index ][ 0 ] == '-' && argv[ argument_index ][ 1 ] ) )
+    {
+        return usage();
+    }
+
+    opts.input_path = argument_index < argc ? argv[ argument_index ] : nullptr;
+
+    std::FILE * input = opts.input_path && std::strcmp( opts.input_path, "-" ) != 0 ? std::fopen( opts.input_path, "rb" ) : stdin;
+    std::FILE * csv = opts.csv_path ? std::fopen( opts.csv_path, "w" ) : nullptr;
+
+    if ( !input || ( opts.csv_path && !csv ) )
+    {
+        std::fprintf( stderr, "simplify_compare: cannot open %s: %s\n", !input ? opts.input_path : opts.csv_path, std::strerror( errno ) );
+
+        return EXIT_FAILURE;
+    }
+
+    if ( csv )
+    {
+        std::fprintf( csv, "engine,seconds,points_per_second,input_point_count,output_point_count,kept_ratio,max_segment_deviation,area_change_ratio\n" );
+    }
+
+    int result = EXIT_FAILURE;
+
+    if ( opts.type == "float" && opts.dimension == 2 ) result = run< float, 2 >( opts, input, csv );
+    else if ( opts.type == "float" && opts.dimension == 3 ) result = run< float, 3 >( opts, input, csv );
+    else if ( opts.type == "double" && opts.dimension == 2 ) result = run< double, 2 >( opts, input, csv );
+    else if ( opts.type == "double" && opts.dimension == 3 ) result = run< double, 3 >( opts, input, csv );
+    else result = usage();
+
+    if ( input != stdin )
+    {
+        std::fclose( input );
+    }
+
+    if ( csv && std::fclose( csv ) != 0 )
+    {
+        std::fprintf( stderr, "simplify_compare: write failed: %s\n", std::strerror( errno ) );
+        result = EXIT_FAILURE;
+    }
+
+    return result;
+}
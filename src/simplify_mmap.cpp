@@ -0,0 +1,262 @@
+#include "simplify.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Simplifies a raw little-endian point file through a memory mapping, either in place or into a
+// second mapped file, and truncates the result to the kept points.
+//
+// usage: simplify_mmap -t float|double -d 2|3 [-e tolerance] [-q] input [output]
+
+#if defined( __BYTE_ORDER__ ) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+    #error "simplify_mmap expects a little-endian host, point files are mapped as is"
+#endif
+
+namespace
+{
+    struct options
+    {
+        std::string type { "float" };
+        std::size_t dimension { 2 };
+        double tolerance { 1.0 };
+        bool highest_quality { false };
+        const char * input_path { nullptr };
+        const char * output_path { nullptr };
+    };
+
+    class mapped_file
+    {
+    public:
+
+        mapped_file() = default;
+        mapped_file( const mapped_file & ) = delete;
+        mapped_file & operator=( const mapped_file & ) = delete;
+
+        ~mapped_file()
+        {
+            close();
+        }
+
+        bool open( const char * path, bool create, std::size_t create_size )
+        {
+            descriptor = ::open( path, create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR, 0644 );
+
+            if ( descriptor < 0 )
+            {
+                return report( "open", path );
+            }
+
+            if ( create )
+            {
+                if ( ::ftruncate( descriptor, static_cast< off_t >( create_size ) ) != 0 )
+                {
+                    return report( "ftruncate", path );
+                }
+
+                size = create_size;
+            }
+            else
+            {
+                struct stat status;
+
+                if ( ::fstat( descriptor, &status ) != 0 )
+                {
+                    return report( "fstat", path );
+                }
+
+                size = static_cast< std::size_t >( status.st_size );
+            }
+
+            if ( size == 0 )
+            {
+                return true;
+            }
+
+            void * address = ::mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0 );
+
+            if ( address == MAP_FAILED )
+            {
+                return report( "mmap", path );
+            }
+
+            data = static_cast< char * >( address );
+            ::madvise( data, size, MADV_SEQUENTIAL );
+
+            return true;
+        }
+
+        bool truncate( std::size_t new_size, const char * path )
+        {
+            unmap();
+
+            if ( ::ftruncate( descriptor, static_cast< off_t >( new_size ) ) != 0 )
+            {
+                return report( "ftruncate", path );
+            }
+
+            size = new_size;
+
+            return true;
+        }
+
+        void close()
+        {
+            unmap();
+
+            if ( descriptor >= 0 )
+            {
+                ::close( descriptor );
+                descriptor = -1;
+            }
+        }
+
+        char * data { nullptr };
+        std::size_t size { 0 };
+
+    private:
+
+        void unmap()
+        {
+            if ( data )
+            {
+                ::munmap( data, size );
+                data = nullptr;
+            }
+        }
+
+        static bool report( const char * operation, const char * path )
+        {
+            std::fprintf( stderr, "simplify_mmap: %s %s: %s\n", operation, path, std::strerror( errno ) );
+
+            return false;
+        }
+
+        int descriptor { -1 };
+    };
+
+    template< class T, std::size_t dimension >
+    int run( const options & opts )
+    {
+        const std::size_t point_size = sizeof( T ) * dimension;
+        mapped_file input, output;
+
+        if ( !input.open( opts.input_path, false, 0 ) )
+        {
+            return EXIT_FAILURE;
+        }
+
+        if ( input.size % point_size != 0 )
+        {
+            std::fprintf( stderr, "simplify_mmap: %s size is not a multiple of %zu bytes\n", opts.input_path, point_size );
+
+            return EXIT_FAILURE;
+        }
+
+        mapped_file * target = &input;
+        const char * target_path = opts.input_path;
+
+        if ( opts.output_path )
+        {
+            if ( !output.open( opts.output_path, true, input.size ) )
+            {
+                return EXIT_FAILURE;
+            }
+
+            if ( input.size )
+            {
+                std::memcpy( output.data, input.data, input.size );
+            }
+
+            input.close();
+            target = &output;
+            target_path = opts.output_path;
+        }
+
+        const std::size_t point_count = target->size / point_size;
+        std::size_t kept_count = point_count;
+
+        if ( point_count )
+        {
+            T * first = reinterpret_cast< T * >( target->data );
+            T * last = ::simplify::helpers::simplify< T, dimension >(
+                first,
+                first + point_count * dimension,
+                static_cast< T >( opts.tolerance ),
+                opts.highest_quality
+                );
+
+            kept_count = static_cast< std::size_t >( last - first ) / dimension;
+        }
+
+        if ( !target->truncate( kept_count * point_size, target_path ) )
+        {
+            return EXIT_FAILURE;
+        }
+
+        std::printf( "%zu %zu\n", point_count, kept_count );
+
+        return EXIT_SUCCESS;
+    }
+
+    int usage()
+    {
+        std::fprintf( stderr, "usage: simplify_mmap -t float|double -d 2|3 [-e tolerance] [-q] input [output]\n" );
+
+        return EXIT_FAILURE;
+    }
+}
+
+int main( int argc, char ** argv )
+{
+    options opts;
+    int argument_index = 1;
+
+    for ( ; argument_index < argc && argv[ argument_index ][ 0 ] == '-'; ++argument_index )
+    {
+        const std::string flag = argv[ argument_index ];
+
+        if ( flag == "-q" )
+        {
+            opts.highest_quality = true;
+        }
+        else if ( argument_index + 1 < argc && flag == "-t" )
+        {
+            opts.type = argv[ ++argument_index ];
+        }
+        else if ( argument_index + 1 < argc && flag == "-d" )
+        {
+            opts.dimension = std::strtoul( argv[ ++argument_index ], nullptr, 10 );
+        }
+        else if ( argument_index + 1 < argc && flag == "-e" )
+        {
+            opts.tolerance = std::strtod( argv[ ++argument_index ], nullptr );
+        }
+        else
+        {
+            return usage();
+        }
+    }
+
+    if ( argument_index == argc || argc - argument_index > 2 )
+    {
+        return usage();
+    }
+
+    opts.input_path = argv[ argument_index ];
+    opts.output_path = argument_index + 1 < argc ? argv[ argument_index + 1 ] : nullptr;
+
+    if ( opts.type == "float" && opts.dimension == 2 ) return run< float, 2 >( opts );
+    if ( opts.type == "float" && opts.dimension == 3 ) return run< float, 3 >( opts );
+    if ( opts.type == "double" && opts.dimension == 2 ) return run< double, 2 >( opts );
+    if ( opts.type == "double" && opts.dimension == 3 ) return run< double, 3 >( opts );
+
+    return usage();
+}
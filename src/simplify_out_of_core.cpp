@@ -0,0 +1,468 @@
+#include "simplify.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stack>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Douglas-Peucker on raw little-endian point files larger than memory.
+//
+// Ranges that do not fit in the memory limit are scanned from disk chunk by chunk to find their
+// farthest point, exactly as simplify_douglas_peucker does for its top levels, and split there.
+// Once a range fits, it is loaded and simplified in memory. Chunk seams are therefore DP split
+// points: the output is identical to the in-memory simplify_douglas_peucker and the tolerance
+// holds across seams.
+//
+// The first scan also records the bounding box of every block of points. Later ranges only read
+// the blocks whose box may hold a point as far as the farthest one found so far, best bound first,
+// as douglas_peucker_box_search does in memory: a range split next to its end, for instance, reads
+// a few blocks again instead of the whole range.
+//
+// usage: simplify_out_of_core -t float|double -d 2|3 [-e tolerance] [-m memory_limit_bytes] input output
+
+#if defined( __BYTE_ORDER__ ) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+    #error "simplify_out_of_core expects a little-endian host, point files are read as is"
+#endif
+
+namespace
+{
+    struct options
+    {
+        std::string type { "float" };
+        std::size_t dimension { 2 };
+        double tolerance { 1.0 };
+        std::size_t memory_limit { std::size_t( 256 ) << 20 };
+        const char * input_path { nullptr };
+        const char * output_path { nullptr };
+    };
+
+    bool report( const char * operation, const char * path )
+    {
+        std::fprintf( stderr, "simplify_out_of_core: %s %s: %s\n", operation, path, std::strerror( errno ) );
+
+        return false;
+    }
+
+    template< class Vector >
+    class point_file
+    {
+    public:
+
+        explicit point_file( const char * path ) :
+            path( path )
+        {
+        }
+
+        point_file( const point_file & ) = delete;
+        point_file & operator=( const point_file & ) = delete;
+
+        ~point_file()
+        {
+            if ( descriptor >= 0 )
+            {
+                ::close( descriptor );
+            }
+        }
+
+        bool open()
+        {
+            struct stat status;
+
+            descriptor = ::open( path, O_RDONLY );
+
+            if ( descriptor < 0 || ::fstat( descriptor, &status ) != 0 )
+            {
+                return report( "open", path );
+            }
+
+            if ( static_cast< std::size_t >( status.st_size ) % sizeof( Vector ) != 0 )
+            {
+                std::fprintf( stderr, "simplify_out_of_core: %s size is not a multiple of %zu bytes\n", path, sizeof( Vector ) );
+
+                return false;
+            }
+
+            size = static_cast< std::size_t >( status.st_size ) / sizeof( Vector );
+            ::posix_fadvise( descriptor, 0, 0, POSIX_FADV_SEQUENTIAL );
+
+            return true;
+        }
+
+        bool read( std::size_t first, std::size_t count, Vector * destination ) const
+        {
+            char * bytes = reinterpret_cast< char * >( destination );
+            std::size_t remaining = count * sizeof( Vector );
+            off_t offset = static_cast< off_t >( first * sizeof( Vector ) );
+
+            while ( remaining )
+            {
+                const ssize_t read_size = ::pread( descriptor, bytes, remaining, offset );
+
+                if ( read_size <= 0 )
+                {
+                    return report( "pread", path );
+                }
+
+                bytes += read_size;
+                offset += read_size;
+                remaining -= static_cast< std::size_t >( read_size );
+            }
+
+            return true;
+        }
+
+        std::size_t size { 0 };
+
+    private:
+
+        const char * path;
+        int descriptor { -1 };
+    };
+
+    struct block_candidate
+    {
+        double square_bound;
+        std::size_t block;
+
+        bool operator<( const block_candidate & other ) const
+        {
+            return square_bound < other.square_bound;
+        }
+    };
+
+    template< class T, std::size_t dimension >
+    int run( const options & opts )
+    {
+        typedef ::simplify::helpers::vect< T, dimension > vec;
+        typedef ::simplify::helpers::promoted_distance_kernel< T, dimension > kernel;
+        typedef std::pair< std::size_t, std::size_t > index_range;
+        typedef std::pair< vec *, vec * > pointer_range;
+
+        point_file< vec > input( opts.input_path );
+
+        if ( !input.open() )
+        {
+            return EXIT_FAILURE;
+        }
+
+        // Each block costs its two box corners and a search candidate. Blocks grow until these take
+        // at most a quarter of the memory limit.
+
+        const std::size_t block_byte_count = 2 * sizeof( vec ) + sizeof( block_candidate );
+        std::size_t block_size = 4096;
+
+        while ( ( input.size + block_size - 1 ) / block_size * block_byte_count > opts.memory_limit / 4 )
+        {
+            block_size *= 2;
+        }
+
+        const std::size_t block_count = ( input.size + block_size - 1 ) / block_size;
+
+        // The in-memory pass needs the points plus, at worst, one iterator per point in its keep
+        // table and two in its range stack.
+
+        const std::size_t chunk_capacity = ( opts.memory_limit - block_count * block_byte_count ) / ( sizeof( vec ) + 3 * sizeof( vec * ) );
+
+        if ( chunk_capacity < 3 )
+        {
+            std::fprintf( stderr, "simplify_out_of_core: memory limit is too small\n" );
+
+            return EXIT_FAILURE;
+        }
+
+        std::FILE * output = std::fopen( opts.output_path, "wb" );
+
+        if ( !output )
+        {
+            report( "fopen", opts.output_path );
+
+            return EXIT_FAILURE;
+        }
+
+        std::vector< vec > chunk( chunk_capacity );
+        std::size_t kept_count = 0;
+        bool success = true;
+
+        // Reserved once, so that the in-memory passes never grow their tables past the limit.
+
+        ::simplify::douglas_peucker_scratch< vec * > scratch;
+        std::vector< pointer_range > range_storage;
+
+        range_storage.reserve( chunk_capacity );
+        scratch.range_to_process_table = std::stack< pointer_range, std::vector< pointer_range > >( std::move( range_storage ) );
+        scratch.to_keep_table.reserve( chunk_capacity );
+
+        auto write = [ & ]( const vec * first, std::size_t count )
+        {
+            if ( std::fwrite( first, sizeof( vec ), count, output ) != count )
+            {
+                success = report( "fwrite", opts.output_path );
+            }
+
+            kept_count += count;
+        };
+
+        if ( input.size <= chunk_capacity )
+        {
+            success = input.read( 0, input.size, chunk.data() );
+
+            if ( success )
+            {
+                const vec * last = ::simplify::simplify_douglas_peucker(
+                    chunk.data(),
+                    chunk.data() + input.size,
+                    static_cast< T >( opts.tolerance ),
+                    &::simplify::helpers::get_point_segment_square_distance< T, vec >,
+                    scratch
+                    );
+
+                write( chunk.data(), static_cast< std::size_t >( last - chunk.data() ) );
+            }
+        }
+        else
+        {
+            const T square_tolerance = static_cast< T >( opts.tolerance ) * static_cast< T >( opts.tolerance );
+            std::vector< index_range > range_to_process_table;
+            std::vector< vec > minimum_table( block_count ), maximum_table( block_count );
+            std::vector< block_candidate > candidate_table;
+            bool has_boxes = false;
+
+            for ( std::size_t block = 0; block < block_count; ++block )
+            {
+                for ( std::size_t i = 0; i < dimension; ++i )
+                {
+                    minimum_table[ block ].values[ i ] = std::numeric_limits< T >::max();
+                    maximum_table[ block ].values[ i ] = std::numeric_limits< T >::lowest();
+                }
+            }
+
+            auto add_to_box = [ & ]( const vec & point, std::size_t index )
+            {
+                vec & minimum = minimum_table[ index / block_size ];
+                vec & maximum = maximum_table[ index / block_size ];
+
+                for ( std::size_t i = 0; i < dimension; ++i )
+                {
+                    minimum.values[ i ] = std::min( minimum.values[ i ], point.values[ i ] );
+                    maximum.values[ i ] = std::max( maximum.values[ i ], point.values[ i ] );
+                }
+            };
+
+            range_to_process_table.push_back( index_range( 0, input.size - 1 ) );
+
+            while( success && !range_to_process_table.empty() )
+            {
+                const index_range range = range_to_process_table.back();
+                const std::size_t range_size = range.second - range.first + 1;
+
+                range_to_process_table.pop_back();
+
+                if ( range_size <= chunk_capacity )
+                {
+                    // Every range starts on the previous range end, which is already written.
+
+                    if ( !input.read( range.first, range_size, chunk.data() ) )
+                    {
+                        success = false;
+                        break;
+                    }
+
+                    const vec * last = ::simplify::simplify_douglas_peucker(
+                        chunk.data(),
+                        chunk.data() + range_size,
+                        static_cast< T >( opts.tolerance ),
+                        &::simplify::helpers::get_point_segment_square_distance< T, vec >,
+                        scratch
+                        );
+
+                    write( chunk.data() + ( range.first == 0 ? 0 : 1 ), static_cast< std::size_t >( last - chunk.data() ) - ( range.first == 0 ? 0 : 1 ) );
+
+                    continue;
+                }
+
+                vec segment_start, segment_end;
+
+                if ( !input.read( range.first, 1, &segment_start ) || !input.read( range.second, 1, &segment_end ) )
+                {
+                    success = false;
+                    break;
+                }
+
+                auto maximum = static_cast< T >( -1 );
+                std::size_t maximum_index = range.first;
+
+                // Equal distances go to the first point, whatever the order the blocks are read in.
+
+                auto scan = [ & ]( std::size_t first_index, std::size_t last_index )
+                {
+                    for ( std::size_t chunk_first = first_index; success && chunk_first < last_index; chunk_first += chunk_capacity )
+                    {
+                        const std::size_t chunk_size = std::min( chunk_capacity, last_index - chunk_first );
+
+                        if ( !input.read( chunk_first, chunk_size, chunk.data() ) )
+                        {
+                            success = false;
+                            break;
+                        }
+
+                        for ( std::size_t i = 0; i < chunk_size; ++i )
+                        {
+                            auto square_distance = kernel::get_point_segment_square_distance( chunk[ i ], segment_start, segment_end );
+
+                            if ( square_distance > maximum || ( square_distance == maximum && chunk_first + i < maximum_index ) )
+                            {
+                                maximum = square_distance;
+                                maximum_index = chunk_first + i;
+                            }
+
+                            if ( !has_boxes )
+                            {
+                                add_to_box( chunk[ i ], chunk_first + i );
+                            }
+                        }
+                    }
+                };
+
+                if ( !has_boxes )
+                {
+                    // The first range is the whole input, so this scan sees every point.
+
+                    add_to_box( segment_start, range.first );
+                    add_to_box( segment_end, range.second );
+                    scan( range.first + 1, range.second );
+                    has_boxes = true;
+                }
+                else
+                {
+                    const double segment_magnitude = ::simplify::helpers::get_segment_magnitude( segment_start, segment_end );
+
+                    candidate_table.clear();
+
+                    for ( std::size_t block = ( range.first + 1 ) / block_size; block <= ( range.second - 1 ) / block_size; ++block )
+                    {
+                        candidate_table.push_back( block_candidate {
+                            ::simplify::helpers::get_box_segment_square_bound< T, dimension, kernel >( minimum_table[ block ], maximum_table[ block ], segment_start, segment_end, segment_magnitude ),
+                            block
+                            } );
+                    }
+
+                    std::make_heap( candidate_table.begin(), candidate_table.end() );
+
+                    while ( success && !candidate_table.empty() )
+                    {
+                        std::pop_heap( candidate_table.begin(), candidate_table.end() );
+
+                        const block_candidate current = candidate_table.back();
+
+                        candidate_table.pop_back();
+
+                        if ( current.square_bound < double( maximum ) )
+                        {
+                            break;
+                        }
+
+                        scan( std::max( current.block * block_size, range.first + 1 ), std::min( ( current.block + 1 ) * block_size, range.second ) );
+                    }
+                }
+
+                if ( !success )
+                {
+                    break;
+                }
+
+                if ( maximum >= square_tolerance )
+                {
+                    range_to_process_table.push_back( index_range( maximum_index, range.second ) );
+                    range_to_process_table.push_back( index_range( range.first, maximum_index ) );
+                }
+                else
+                {
+                    if ( range.first == 0 )
+                    {
+                        write( &segment_start, 1 );
+                    }
+
+                    write( &segment_end, 1 );
+                }
+            }
+        }
+
+        if ( std::fclose( output ) != 0 )
+        {
+            success = report( "fclose", opts.output_path );
+        }
+
+        if ( !success )
+        {
+            return EXIT_FAILURE;
+        }
+
+        std::printf( "%zu %zu\n", input.size, kept_count );
+
+        return EXIT_SUCCESS;
+    }
+
+    int usage()
+    {
+        std::fprintf( stderr, "usage: simplify_out_of_core -t float|double -d 2|3 [-e tolerance] [-m memory_limit_bytes] input output\n" );
+
+        return EXIT_FAILURE;
+    }
+}
+
+int main( int argc, char ** argv )
+{
+    options opts;
+    int argument_index = 1;
+
+    for ( ; argument_index + 1 < argc && argv[ argument_index ][ 0 ] == '-'; argument_index += 2 )
+    {
+        const std::string flag = argv[ argument_index ];
+        const char * value = argv[ argument_index + 1 ];
+
+        if ( flag == "-t" )
+        {
+            opts.type = value;
+        }
+        else if ( flag == "-d" )
+        {
+            opts.dimension = std::strtoul( value, nullptr, 10 );
+        }
+        else if ( flag == "-e" )
+        {
+            opts.tolerance = std::strtod( value, nullptr );
+        }
+        else if ( flag == "-m" )
+        {
+            opts.memory_limit = std::strtoull( value, nullptr, 10 );
+        }
+        else
+        {
+            return usage();
+        }
+    }
+
+    if ( argc - argument_index != 2 )
+    {
+        return usage();
+    }
+
+    opts.input_path = argv[ argument_index ];
+    opts.output_path = argv[ argument_index + 1 ];
+
+    if ( opts.type == "float" && opts.dimension == 2 ) return run< float, 2 >( opts );
+    if ( opts.type == "float" && opts.dimension == 3 ) return run< float, 3 >( opts );
+    if ( opts.type == "double" && opts.dimension == 2 ) return run< double, 2 >( opts );
+    if ( opts.type == "double" && opts.dimension == 3 ) return run< double, 3 >( opts );
+
+    return usage();
+}
@@ -0,0 +1,359 @@
+#include "simplify.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <future>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Simplifies a stream of polylines with overlapped I/O and computation: a reader thread, a pool of
+// simplifying workers and an ordered writer, connected by bounded queues for backpressure.
+//
+// Each polyline in the input and output streams is a little-endian uint64 point count followed by
+// the points as raw little-endian values.
+//
+// usage: simplify_pipeline -t float|double -d 2|3 [-e tolerance] [-q] [-j workers] [-b queue_capacity] [input [output]]
+
+#if defined( __BYTE_ORDER__ ) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+    #error "simplify_pipeline expects a little-endian host, point streams are read as is"
+#endif
+
+namespace
+{
+    struct options
+    {
+        std::string type { "float" };
+        std::size_t dimension { 2 };
+        double tolerance { 1.0 };
+        bool highest_quality { false };
+        std::size_t worker_count { std::max( 1u, std::thread::hardware_concurrency() ) };
+        std::size_t queue_capacity { 256 };
+        const char * input_path { nullptr };
+        const char * output_path { nullptr };
+    };
+
+    template< class Item >
+    class bounded_queue
+    {
+    public:
+
+        explicit bounded_queue( std::size_t capacity ) :
+            capacity( capacity )
+        {
+        }
+
+        void push( Item item )
+        {
+            std::unique_lock< std::mutex > lock( mutex );
+
+            not_full.wait( lock, [ this ] { return item_table.size() < capacity; } );
+            item_table.push_back( std::move( item ) );
+            not_empty.notify_one();
+        }
+
+        // Returns false once the queue is closed and drained.
+
+        bool pop( Item & item )
+        {
+            std::unique_lock< std::mutex > lock( mutex );
+
+            not_empty.wait( lock, [ this ] { return !item_table.empty() || closed; } );
+
+            if ( item_table.empty() )
+            {
+                return false;
+            }
+
+            item = std::move( item_table.front() );
+            item_table.pop_front();
+            not_full.notify_one();
+
+            return true;
+        }
+
+        void close()
+        {
+            std::lock_guard< std::mutex > lock( mutex );
+
+            closed = true;
+            not_empty.notify_all();
+        }
+
+    private:
+
+        std::mutex mutex;
+        std::condition_variable not_empty, not_full;
+        std::deque< Item > item_table;
+        std::size_t capacity;
+        bool closed { false };
+    };
+
+    template< class T >
+    struct job
+    {
+        std::vector< T > coordinates;
+        std::promise< std::vector< T > > result;
+    };
+
+    template< class T, std::size_t dimension >
+    int run( const options & opts, std::FILE * input, std::FILE * output )
+    {
+        typedef std::unique_ptr< job< T > > job_pointer;
+
+        bounded_queue< job_pointer > work_queue( opts.queue_capacity );
+        bounded_queue< std::future< std::vector< T > > > write_queue( opts.queue_capacity );
+        bool read_success = true, write_success = true;
+        std::size_t polyline_count = 0, output_point_count = 0;
+        std::exception_ptr read_exception;
+
+        // Coordinates are read in slices, so that a corrupt point count fails at the end of the input
+        // instead of allocating its whole size up front. Exceptions, such as std::bad_alloc, are
+        // handed to the main thread: through read_exception for the reader, and through the job
+        // result for the workers.
+
+        const std::size_t slice_size = std::size_t( 1 ) << 20;
+
+        std::thread reader( [ & ]
+        {
+            try
+            {
+                std::uint64_t point_count;
+
+                while ( read_success && std::fread( &point_count, sizeof( point_count ), 1, input ) == 1 )
+                {
+                    if ( point_count > std::numeric_limits< std::size_t >::max() / ( dimension * sizeof( T ) ) )
+                    {
+                        read_success = false;
+                        break;
+                    }
+
+                    const std::size_t coordinate_count = static_cast< std::size_t >( point_count ) * dimension;
+                    job_pointer new_job( new job< T >() );
+                    std::vector< T > & coordinates = new_job->coordinates;
+
+                    while ( coordinates.size() < coordinate_count )
+                    {
+                        const std::size_t read_first = coordinates.size();
+                        const std::size_t read_count = std::min( slice_size, coordinate_count - read_first );
+
+                        coordinates.resize( read_first + read_count );
+
+                        if ( std::fread( coordinates.data() + read_first, sizeof( T ), read_count, input ) != read_count )
+                        {
+                            read_success = false;
+                            break;
+                        }
+                    }
+
+                    if ( read_success )
+                    {
+                        write_queue.push( new_job->result.get_future() );
+                        work_queue.push( std::move( new_job ) );
+                    }
+                }
+
+                read_success = read_success && !std::ferror( input );
+            }
+            catch ( ... )
+            {
+                read_exception = std::current_exception();
+                read_success = false;
+            }
+
+            work_queue.close();
+            write_queue.close();
+        } );
+
+        std::vector< std::thread > worker_table;
+
+        for ( std::size_t worker_index = 0; worker_index < opts.worker_count; ++worker_index )
+        {
+            worker_table.emplace_back( [ & ]
+            {
+                job_pointer current_job;
+
+                while ( work_queue.pop( current_job ) )
+                {
+                    try
+                    {
+                        std::vector< T > & coordinates = current_job->coordinates;
+                        T * first = coordinates.data();
+                        T * last = ::simplify::helpers::simplify< T, dimension >(
+                            first,
+                            first + coordinates.size(),
+                            static_cast< T >( opts.tolerance ),
+                            opts.highest_quality
+                            );
+
+                        coordinates.resize( static_cast< std::size_t >( last - first ) );
+                        current_job->result.set_value( std::move( coordinates ) );
+                    }
+                    catch ( ... )
+                    {
+                        current_job->result.set_exception( std::current_exception() );
+                    }
+                }
+            } );
+        }
+
+        std::future< std::vector< T > > pending;
+
+        while ( write_queue.pop( pending ) )
+        {
+            std::vector< T > coordinates;
+
+            try
+            {
+                coordinates = pending.get();
+            }
+            catch ( const std::exception & error )
+            {
+                std::fprintf( stderr, "simplify_pipeline: polyline %zu failed: %s\n", polyline_count, error.what() );
+                write_success = false;
+                ++polyline_count;
+                continue;
+            }
+
+            const std::uint64_t point_count = coordinates.size() / dimension;
+
+            if ( write_success
+                && ( std::fwrite( &point_count, sizeof( point_count ), 1, output ) != 1
+                    || std::fwrite( coordinates.data(), sizeof( T ), coordinates.size(), output ) != coordinates.size() ) )
+            {
+                write_success = false;
+            }
+
+            ++polyline_count;
+            output_point_count += coordinates.size() / dimension;
+        }
+
+        reader.join();
+
+        for ( auto & worker : worker_table )
+        {
+            worker.join();
+        }
+
+        if ( read_exception )
+        {
+            try
+            {
+                std::rethrow_exception( read_exception );
+            }
+            catch ( const std::exception & error )
+            {
+                std::fprintf( stderr, "simplify_pipeline: read failed: %s\n", error.what() );
+            }
+        }
+        else if ( !read_success )
+        {
+            std::fprintf( stderr, "simplify_pipeline: truncated or unreadable input\n" );
+        }
+
+        if ( std::fflush( output ) != 0 || !write_success )
+        {
+            std::fprintf( stderr, "simplify_pipeline: write failed: %s\n", std::strerror( errno ) );
+            write_success = false;
+        }
+
+        std::fprintf( stderr, "%zu polylines, %zu points kept\n", polyline_count, output_point_count );
+
+        return read_success && write_success ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    int usage()
+    {
+        std::fprintf( stderr, "usage: simplify_pipeline -t float|double -d 2|3 [-e tolerance] [-q] [-j workers] [-b queue_capacity] [input [output]]\n" );
+
+        return EXIT_FAILURE;
+    }
+}
+
+int main( int argc, char ** argv )
+{
+    options opts;
+    int argument_index = 1;
+
+    for ( ; argument_index < argc && argv[ argument_index ][ 0 ] == '-' && argv[ argument_index ][ 1 ]; ++argument_index )
+    {
+        const std::string flag = argv[ argument_index ];
+
+        if ( flag == "-q" )
+        {
+            opts.highest_quality = true;
+        }
+        else if ( argument_index + 1 < argc && flag == "-t" )
+        {
+            opts.type = argv[ ++argument_index ];
+        }
+        else if ( argument_index + 1 < argc && flag == "-d" )
+        {
+            opts.dimension = std::strtoul( argv[ ++argument_index ], nullptr, 10 );
+        }
+        else if ( argument_index + 1 < argc && flag == "-e" )
+        {
+            opts.tolerance = std::strtod( argv[ ++argument_index ], nullptr );
+        }
+        else if ( argument_index + 1 < argc && flag == "-j" )
+        {
+            opts.worker_count = std::max< std::size_t >( 1, std::strtoul( argv[ ++argument_index ], nullptr, 10 ) );
+        }
+        else if ( argument_index + 1 < argc && flag == "-b" )
+        {
+            opts.queue_capacity = std::max< std::size_t >( 1, std::strtoul( argv[ ++argument_index ], nullptr, 10 ) );
+        }
+        else
+        {
+            return usage();
+        }
+    }
+
+    if ( argc - argument_index > 2 )
+    {
+        return usage();
+    }
+
+    opts.input_path = argument_index < argc ? argv[ argument_index ] : nullptr;
+    opts.output_path = argument_index + 1 < argc ? argv[ argument_index + 1 ] : nullptr;
+
+    std::FILE * input = opts.input_path && std::strcmp( opts.input_path, "-" ) != 0 ? std::fopen( opts.input_path, "rb" ) : stdin;
+    std::FILE * output = opts.output_path && std::strcmp( opts.output_path, "-" ) != 0 ? std::fopen( opts.output_path, "wb" ) : stdout;
+
+    if ( !input || !output )
+    {
+        std::fprintf( stderr, "simplify_pipeline: cannot open %s: %s\n", !input ? opts.input_path : opts.output_path, std::strerror( errno ) );
+
+        return EXIT_FAILURE;
+    }
+
+    int result = EXIT_FAILURE;
+
+    if ( opts.type == "float" && opts.dimension == 2 ) result = run< float, 2 >( opts, input, output );
+    else if ( opts.type == "float" && opts.dimension == 3 ) result = run< float, 3 >( opts, input, output );
+    else if ( opts.type == "double" && opts.dimension == 2 ) result = run< double, 2 >( opts, input, output );
+    else if ( opts.type == "double" && opts.dimension == 3 ) result = run< double, 3 >( opts, input, output );
+    else result = usage();
+
+    if ( input != stdin )
+    {
+        std::fclose( input );
+    }
+
+    if ( output != stdout && std::fclose( output ) != 0 )
+    {
+        result = EXIT_FAILURE;
+    }
+
+    return result;
+}
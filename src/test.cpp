@@ -1,5 +1,10 @@
 #include "simplify.hpp"
 
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <sstream>
+#include <string>
 #include <vector>
 
 #define CATCH_CONFIG_MAIN
@@ -61,6 +66,97 @@ TEST_CASE( "simplify_radial_distance: simplifies points correctly with the given
     REQUIRE( std::equal( points.begin(), new_last, simplified.begin() ) );
 }
 
+TEST_CASE( "simplify_radial_distance_copy: copies zero, one or two points as is from an input iterator (1D)", "[simplify_radial]" )
+{
+    auto get_point_point_square_distance = []( const float & first, const float & second ) { auto diff = second - first; return diff * diff; };
+
+    for ( auto input : { std::string( "" ), std::string( "1.0" ), std::string( "1.0 1.1" ) } )
+    {
+        std::istringstream stream( input );
+        std::vector< float > simplified;
+
+        simplify::simplify_radial_distance_copy( std::istream_iterator< float >( stream ), std::istream_iterator< float >(), std::back_inserter( simplified ), 1.0f, get_point_point_square_distance );
+        REQUIRE( simplified.size() == static_cast< std::size_t >( std::count( input.begin(), input.end(), '.' ) ) );
+    }
+}
+
+TEST_CASE( "simplify_radial_distance_copy: matches simplify_radial_distance when reading from a stream (1D)", "[simplify_radial]" )
+{
+    float points[] { 0.0f, 0.1f, 0.5f, 0.99f, 1.0f, 1.01f, 1.5f, 2.0f, 2.1f },
+        simplified[] { 0.0f, 1.0f, 2.0f, 2.1f };
+
+    auto get_point_point_square_distance = []( const float & first, const float & second ) { auto diff = second - first; return diff * diff; };
+
+    std::ostringstream output;
+    std::copy( std::begin( points ), std::end( points ), std::ostream_iterator< float >( output, " " ) );
+
+    std::istringstream input( output.str() );
+    std::vector< float > result;
+
+    simplify::simplify_radial_distance_copy( std::istream_iterator< float >( input ), std::istream_iterator< float >(), std::back_inserter( result ), 1.0f, get_point_point_square_distance );
+    REQUIRE( result.size() == sizeof( simplified ) / sizeof( simplified[ 0 ] ) );
+    REQUIRE( std::equal( result.begin(), result.end(), simplified ) );
+}
+
+TEST_CASE( "helpers::simplify_radial_distance: matches simplify_radial_distance on contiguous points (3D)", "[simplify_radial]" )
+{
+    using vec3f = simplify::helpers::vect< float, 3 >;
+
+    std::vector< vec3f > points;
+
+    for ( int i = 0; i < 2000; ++i )
+    {
+        points.push_back( vec3f { { float( i % 97 ) * 0.01f, float( i % 13 ) * 0.02f, float( i / 50 ) * 0.3f } } );
+    }
+
+    for ( float tolerance : { 0.0f, 0.05f, 0.2f, 1.0f, 100.0f } )
+    {
+        std::vector< vec3f > expected = points, simplified = points;
+
+        auto expected_last = simplify::simplify_radial_distance( expected.begin(), expected.end(), tolerance, &simplify::helpers::get_point_point_square_distance< float, vec3f > );
+        auto new_last = simplify::helpers::simplify_radial_distance( simplified.data(), simplified.data() + simplified.size(), tolerance );
+        REQUIRE( new_last - simplified.data() == expected_last - expected.begin() );
+        REQUIRE( std::equal( expected.begin(), expected_last, simplified.data() ) );
+    }
+}
+
+// simplify_grid_snap
+
+TEST_CASE( "simplify_grid_snap: drops points falling in the cell of their predecessor (keeping both ends) (1D)", "[simplify_grid_snap]" )
+{
+    float points[] { 0.0f, 0.1f, 0.5f, 0.99f, 1.0f, 1.01f, 1.5f, 2.0f, 2.1f },
+        simplified[] { 0.0f, 1.0f, 2.0f, 2.1f };
+
+    auto get_cell = []( float point, float cell_size ) { return int( std::floor( point / cell_size ) ); };
+
+    auto new_last = simplify::simplify_grid_snap( points, points + 2, 1.0f, get_cell );
+    REQUIRE( new_last == points + 2 );
+
+    new_last = simplify::simplify_grid_snap( points, points + sizeof( points ) / sizeof( points[ 0 ] ), 1.0f, get_cell );
+    REQUIRE( std::size_t( new_last - points ) == sizeof( simplified ) / sizeof( simplified[ 0 ] ) );
+    REQUIRE( std::equal( points, new_last, simplified ) );
+}
+
+TEST_CASE( "simplify_grid_snap: gives the same result on several threads (2D)", "[simplify_grid_snap]" )
+{
+    using vec2d = simplify::helpers::vect< double, 2 >;
+
+    std::vector< vec2d > points;
+
+    for ( int i = 0; i < 1000000; ++i )
+    {
+        points.push_back( vec2d { { i * 0.013, ( i % 1000 ) * 0.0021 } } );
+    }
+
+    std::vector< vec2d > simplified = points;
+
+    auto new_last = simplify::simplify_grid_snap( points.begin(), points.end(), 0.1, &simplify::helpers::get_point_cell< double, 2 >, 4 );
+    auto simplified_last = simplify::simplify_grid_snap( simplified.begin(), simplified.end(), 0.1, &simplify::helpers::get_point_cell< double, 2 >, 1 );
+    REQUIRE( new_last - points.begin() == simplified_last - simplified.begin() );
+    REQUIRE( std::equal( points.begin(), new_last, simplified.begin() ) );
+    REQUIRE( new_last[ -1 ] == simplified.back() );
+}
+
 // simplify_douglas_peucker
 
 TEST_CASE( "simplify_douglas_peucker: just returns the points if it has only zero, one or two points (2D)", "[simplify_douglas_peucker]" )
@@ -142,8 +238,177 @@ TEST_CASE( "simplify_douglas_peucker: simplify aligned points properly (2D)", "[
     REQUIRE( std::equal( points.begin(), new_last, simplified_1.begin() ) );
 }
 
+TEST_CASE( "simplify_douglas_peucker: fills the statistics of its scratch (2D)", "[simplify_douglas_peucker]" )
+{
+    using vec2d = simplify::helpers::vect< double, 2 >;
+
+    vec2d points[] { { { 0.0, 0.0 } }, { { 1.0, 5.0 } }, { { 2.0, 0.0 } }, { { 3.0, 0.0 } }, { { 4.0, 0.0 } } };
+    simplify::douglas_peucker_scratch< vec2d *, simplify::simplify_statistics > scratch;
+
+    auto new_last = simplify::simplify_douglas_peucker( points, points + 5, 1.0, &simplify::helpers::get_point_segment_square_distance< double, vec2d >, scratch );
+    REQUIRE( new_last == points + 4 );
+    REQUIRE( scratch.statistics.metric_evaluation_count == 6 );
+    REQUIRE( scratch.statistics.split_count == 2 );
+    REQUIRE( scratch.statistics.maximum_range_depth == 2 );
+    REQUIRE( scratch.statistics.maximum_scratch_byte_count == 2 * sizeof( std::pair< vec2d *, vec2d * > ) + 4 * sizeof( vec2d * ) );
+    REQUIRE( scratch.statistics.radial_kept_count == 0 );
+}
+
+TEST_CASE( "simplify_douglas_peucker: reports every range to its observer (2D)", "[simplify_douglas_peucker]" )
+{
+    using vec2d = simplify::helpers::vect< double, 2 >;
+
+    struct observed_range
+    {
+        std::size_t first_index, last_index, split_index;
+        bool is_split;
+    };
+
+    vec2d points[] { { { 0.0, 0.0 } }, { { 1.0, 5.0 } }, { { 2.0, 0.0 } }, { { 3.0, 0.0 } }, { { 4.0, 0.0 } } };
+    const observed_range expected[] { { 0, 4, 1, true }, { 0, 1, 1, false }, { 1, 4, 2, true }, { 1, 2, 2, false }, { 2, 4, 3, false } };
+    std::vector< observed_range > observed;
+    std::vector< double > maximum_table;
+    simplify::douglas_peucker_scratch< vec2d * > scratch;
+
+    auto observer = [ & ]( std::size_t first_index, std::size_t last_index, std::size_t split_index, double maximum, bool is_split )
+    {
+        observed.push_back( observed_range { first_index, last_index, split_index, is_split } );
+        maximum_table.push_back( maximum );
+    };
+
+    auto new_last = simplify::simplify_douglas_peucker( points, points + 5, 1.0, &simplify::helpers::get_point_segment_square_distance< double, vec2d >, scratch, observer );
+    REQUIRE( new_last == points + 4 );
+    REQUIRE( observed.size() == 5 );
+
+    for ( std::size_t i = 0; i < observed.size(); ++i )
+    {
+        REQUIRE( observed[ i ].first_index == expected[ i ].first_index );
+        REQUIRE( observed[ i ].last_index == expected[ i ].last_index );
+        REQUIRE( observed[ i ].split_index == expected[ i ].split_index );
+        REQUIRE( observed[ i ].is_split == expected[ i ].is_split );
+    }
+
+    REQUIRE( maximum_table[ 0 ] == 25.0 );
+    REQUIRE( maximum_table[ 1 ] == -1.0 );
+    REQUIRE( maximum_table[ 4 ] == 0.0 );
+}
+
+TEST_CASE( "simplify_douglas_peucker_levels: matches simplify_douglas_peucker for each tolerance (2D)", "[simplify_douglas_peucker]" )
+{
+    using vec2f = simplify::helpers::vect< float, 2 >;
+
+    std::vector< vec2f > points;
+    float tolerances[] { 8.0f, 4.0f, 2.0f, 1.0f, 0.5f };
+
+    for ( int i = 0; i < 500; ++i )
+    {
+        points.push_back( vec2f { { float( i ), float( ( i * 37 ) % 23 ) + float( i % 50 ) * 0.5f } } );
+    }
+
+    std::vector< unsigned char > levels( points.size() );
+
+    auto levels_last = simplify::simplify_douglas_peucker_levels( points.begin(), points.end(), std::begin( tolerances ), std::end( tolerances ), levels.begin(), &simplify::helpers::get_point_segment_square_distance< float, vec2f > );
+    REQUIRE( levels_last == levels.end() );
+    REQUIRE( levels.front() == 0 );
+    REQUIRE( levels.back() == 0 );
+
+    for ( unsigned char level = 0; level < 5; ++level )
+    {
+        std::vector< vec2f > simplified = points, from_levels;
+
+        simplified.erase( simplify::simplify_douglas_peucker( simplified.begin(), simplified.end(), tolerances[ level ], &simplify::helpers::get_point_segment_square_distance< float, vec2f > ), simplified.end() );
+
+        for ( std::size_t i = 0; i < points.size(); ++i )
+        {
+            if ( levels[ i ] <= level )
+            {
+                from_levels.push_back( points[ i ] );
+            }
+        }
+
+        REQUIRE( from_levels.size() == simplified.size() );
+        REQUIRE( std::equal( from_levels.begin(), from_levels.end(), simplified.begin() ) );
+    }
+}
+
 // simplify
 
+TEST_CASE( "helpers: vector functions are usable in constant expressions (3D)", "[simplify]" )
+{
+    using vec3i = simplify::helpers::vect< int, 3 >;
+
+    constexpr vec3i first { { 1, 2, 3 } }, second { { 4, 6, 3 } };
+
+    static_assert( simplify::helpers::dot( first, second ) == 25, "dot" );
+    static_assert( simplify::helpers::difference_dot( second, first, second, first ) == 25, "difference_dot" );
+    static_assert( ( second - first ) == vec3i { { 3, 4, 0 } }, "operator-" );
+    static_assert( !( first == second ), "operator==" );
+    static_assert( simplify::helpers::lerp( first, second, 0.5 ) == vec3i { { 2, 4, 3 } }, "lerp" );
+    static_assert( simplify::helpers::get_point_point_square_distance< int >( first, second ) == 25, "get_point_point_square_distance" );
+    static_assert( simplify::helpers::lerp_square_distance( vec3i { { 2, 4, 5 } }, first, second, 0.5 ) == 4, "lerp_square_distance" );
+
+    REQUIRE( simplify::helpers::get_point_segment_square_distance< int >( vec3i { { 2, 3, 4 } }, vec3i { { 0, 0, 0 } }, vec3i { { 4, 0, 0 } } ) == 25 );
+}
+
+TEST_CASE( "remove_redundant_points: drops duplicates and points going straight on, keeping both ends (2D)", "[simplify]" )
+{
+    using vec2i = simplify::helpers::vect< int, 2 >;
+
+    std::vector< vec2i > points {
+            { 0, 0 },
+            { 0, 0 },
+            { 1, 1 },
+            { 2, 2 },
+            { 2, 2 },
+            { 3, 3 },
+            { 1, 1 },
+            { 1, 2 },
+            { 1, 3 },
+            { 1, 3 }
+        },
+        simplified {
+            { 0, 0 },
+            { 3, 3 },
+            { 1, 1 }
+        };
+
+    for ( int i = 0; i < 40; ++i )
+    {
+        points.push_back( vec2i { { 1, 3 } } );
+    }
+
+    for ( int i = 4; i < 40; ++i )
+    {
+        points.push_back( vec2i { { 1, i } } );
+    }
+
+    simplified.push_back( vec2i { { 1, 39 } } );
+
+    auto new_last = simplify::helpers::remove_redundant_points( points.data(), points.data() + points.size() );
+    REQUIRE( std::size_t( new_last - points.data() ) == simplified.size() );
+    REQUIRE( std::equal( points.data(), new_last, simplified.begin() ) );
+}
+
+TEST_CASE( "simplify: grid snapping can replace the radial distance pre-pass", "[simplify]" )
+{
+    double points[] { 0.0, 0.0, 0.1, 0.0, 0.2, 0.1, 1.4, 0.0, 1.5, 0.0, 2.2, 0.0 },
+        simplified[] { 0.0, 0.0, 2.2, 0.0 };
+
+    auto new_last = simplify::simplify2d( points, points + sizeof( points ) / sizeof( points[ 0 ] ), 1.0, simplify::helpers::pre_pass::grid_snap );
+    REQUIRE( new_last == points + 4 );
+    REQUIRE( std::equal( points, new_last, simplified ) );
+}
+
+TEST_CASE( "simplify: removing redundant points first keeps the shape", "[simplify]" )
+{
+    float points[] { 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 2.0f, 0.0f, 2.0f, 0.0f, 2.0f, 5.0f },
+        simplified[] { 0.0f, 0.0f, 2.0f, 0.0f, 2.0f, 5.0f };
+
+    auto new_last = simplify::simplify2f( points, points + sizeof( points ) / sizeof( points[ 0 ] ), 0.5f, simplify::helpers::pre_pass::none, simplify::helpers::redundant_points::remove );
+    REQUIRE( new_last == points + 6 );
+    REQUIRE( std::equal( points, new_last, simplified ) );
+}
+
 TEST_CASE( "simplify: simplifies points correctly with the given tolerance", "[simplify]" )
 {
     float points[] {
@@ -288,6 +553,455 @@ TEST_CASE( "simplify: simplifies points correctly with the given tolerance", "[s
     REQUIRE( std::equal( points, new_last, simplified ) );
 }
 
+TEST_CASE( "simplify_radial_douglas_peucker: matches the radial distance pass followed by simplify_douglas_peucker (2D)", "[simplify]" )
+{
+    using vec2d = simplify::helpers::vect< double, 2 >;
+
+    std::vector< vec2d > points;
+
+    for ( int i = 0; i < 3000; ++i )
+    {
+        points.push_back( vec2d { { std::cos( i * 0.01 ) * i * 0.1, std::sin( i * 0.013 ) * ( i % 17 ) } } );
+    }
+
+    for ( std::size_t point_count : { std::size_t( 0 ), std::size_t( 2 ), std::size_t( 3 ), std::size_t( 40 ), points.size() } )
+    {
+        for ( double tolerance : { 0.0, 0.5, 2.0, 50.0 } )
+        {
+            std::vector< vec2d > expected( points.begin(), points.begin() + point_count ), fused = expected, helpers_fused = expected;
+            simplify::douglas_peucker_scratch< vec2d * > scratch;
+
+            auto expected_last = simplify::simplify_radial_distance( expected.begin(), expected.end(), tolerance, &simplify::helpers::get_point_point_square_distance< double, vec2d > );
+            expected_last = simplify::simplify_douglas_peucker( expected.begin(), expected_last, tolerance, &simplify::helpers::get_point_segment_square_distance< double, vec2d > );
+
+            auto fused_last = simplify::simplify( fused.begin(), fused.end(), tolerance, &simplify::helpers::get_point_segment_square_distance< double, vec2d >, &simplify::helpers::get_point_point_square_distance< double, vec2d > );
+            REQUIRE( fused_last - fused.begin() == expected_last - expected.begin() );
+            REQUIRE( std::equal( expected.begin(), expected_last, fused.begin() ) );
+
+            auto helpers_fused_last = simplify::helpers::simplify_radial_douglas_peucker( helpers_fused.data(), helpers_fused.data() + helpers_fused.size(), tolerance, scratch );
+            REQUIRE( helpers_fused_last - helpers_fused.data() == expected_last - expected.begin() );
+            REQUIRE( std::equal( expected.begin(), expected_last, helpers_fused.data() ) );
+        }
+    }
+}
+
+TEST_CASE( "simplify_radial_douglas_peucker: the helpers engine counts like the generic one (2D)", "[simplify]" )
+{
+    using vec2d = simplify::helpers::vect< double, 2 >;
+
+    std::vector< vec2d > points;
+
+    for ( int i = 0; i < 1000; ++i )
+    {
+        points.push_back( vec2d { { i * 0.3, std::sin( i * 0.05 ) * 6.0 + ( i % 3 ) * 0.4 } } );
+    }
+
+    // The second input ends within tolerance of the last point kept, which radial drops and then
+    // appends as the end.
+
+    std::vector< vec2d > short_end_points = points;
+
+    short_end_points.push_back( vec2d { { points.back().values[ 0 ] + 0.1, points.back().values[ 1 ] } } );
+
+    for ( const std::vector< vec2d > & input : { points, short_end_points } )
+    {
+        std::vector< vec2d > generic = input, helpers = input;
+        simplify::douglas_peucker_scratch< vec2d *, simplify::simplify_statistics > generic_scratch, helpers_scratch;
+
+        auto generic_last = simplify::simplify_radial_douglas_peucker( generic.data(), generic.data() + generic.size(), 0.5, &simplify::helpers::get_point_segment_square_distance< double, vec2d >, &simplify::helpers::get_point_point_square_distance< double, vec2d >, generic_scratch );
+        auto helpers_last = simplify::helpers::simplify_radial_douglas_peucker( helpers.data(), helpers.data() + helpers.size(), 0.5, helpers_scratch );
+        REQUIRE( helpers_last - helpers.data() == generic_last - generic.data() );
+        REQUIRE( helpers_scratch.statistics.radial_kept_count == generic_scratch.statistics.radial_kept_count );
+        REQUIRE( helpers_scratch.statistics.radial_kept_count < input.size() );
+        REQUIRE( helpers_scratch.statistics.metric_evaluation_count == generic_scratch.statistics.metric_evaluation_count );
+        REQUIRE( helpers_scratch.statistics.split_count == generic_scratch.statistics.split_count );
+        REQUIRE( helpers_scratch.statistics.maximum_range_depth == generic_scratch.statistics.maximum_range_depth );
+    }
+}
+
+TEST_CASE( "simplify_douglas_peucker: the helpers engine splits spirals like the generic one with fewer evaluations (2D)", "[simplify]" )
+{
+    using vec2f = simplify::helpers::vect< float, 2 >;
+    using kernel = simplify::helpers::distance_kernel< float, 2 >;
+
+    std::vector< vec2f > points;
+
+    for ( int i = 0; i < 20000; ++i )
+    {
+        const float radius = 1000.0f - i * 0.05f;
+
+        points.push_back( vec2f { { 5000.0f + radius * std::cos( i * 0.01f ), -200.0f + radius * std::sin( i * 0.01f ) } } );
+    }
+
+    for ( float tolerance : { 0.0f, 0.01f, 1.0f } )
+    {
+        std::vector< vec2f > generic = points, helpers = points;
+        simplify::douglas_peucker_scratch< vec2f *, simplify::simplify_statistics > generic_scratch, helpers_scratch;
+
+        auto generic_last = simplify::simplify_douglas_peucker( generic.data(), generic.data() + generic.size(), tolerance, &kernel::get_point_segment_square_distance, generic_scratch );
+        auto helpers_last = simplify::helpers::simplify_douglas_peucker( helpers.data(), helpers.data() + helpers.size(), tolerance, helpers_scratch );
+        REQUIRE( helpers_last - helpers.data() == generic_last - generic.data() );
+        REQUIRE( std::equal( generic.data(), generic_last, helpers.data() ) );
+        REQUIRE( helpers_scratch.statistics.split_count == generic_scratch.statistics.split_count );
+        REQUIRE( helpers_scratch.statistics.metric_evaluation_count < generic_scratch.statistics.metric_evaluation_count );
+    }
+}
+
+TEST_CASE( "simplify_douglas_peucker: the helpers engine stays subquadratic on a zigzag split at its end every time (2D)", "[simplify]" )
+{
+    using vec2d = simplify::helpers::vect< double, 2 >;
+    using kernel = simplify::helpers::distance_kernel< double, 2 >;
+
+    std::vector< vec2d > points;
+
+    // The farthest point of every range is its last interior one, and the distances rise along the
+    // range, so a scan in point order never skips anything.
+
+    for ( int i = 0; i < 8000; ++i )
+    {
+        points.push_back( vec2d { { double( i ), ( i % 2 ? 1.0 : -1.0 ) * ( 1.0 + i * 1e-3 ) } } );
+    }
+
+    std::vector< vec2d > generic = points, helpers = points;
+    simplify::douglas_peucker_scratch< vec2d *, simplify::simplify_statistics > generic_scratch, helpers_scratch;
+
+    auto generic_last = simplify::simplify_douglas_peucker( generic.data(), generic.data() + generic.size(), 0.5, &kernel::get_point_segment_square_distance, generic_scratch );
+    auto helpers_last = simplify::helpers::simplify_douglas_peucker( helpers.data(), helpers.data() + helpers.size(), 0.5, helpers_scratch );
+    REQUIRE( helpers_last - helpers.data() == generic_last - generic.data() );
+    REQUIRE( std::equal( generic.data(), generic_last, helpers.data() ) );
+    REQUIRE( generic_scratch.statistics.metric_evaluation_count > points.size() * points.size() / 4 );
+    REQUIRE( helpers_scratch.statistics.metric_evaluation_count < generic_scratch.statistics.metric_evaluation_count / 10 );
+}
+
+TEST_CASE( "simplify: compares distances exactly on the whole int range", "[simplify]" )
+{
+    int points[] {
+            -2000000000, -2000000000,
+            -1000000000, -1000000000,
+            0, 10,
+            1000000000, 1000000000,
+            2000000000, 2000000000
+        },
+        simplified_7[] {
+            -2000000000, -2000000000,
+            0, 10,
+            2000000000, 2000000000
+        },
+        simplified_8[] {
+            -2000000000, -2000000000,
+            2000000000, 2000000000
+        };
+
+    int copy[ 10 ];
+
+    std::copy( std::begin( points ), std::end( points ), copy );
+    auto new_last = simplify::simplify2i( copy, copy + 10, 7, true );
+    REQUIRE( new_last == copy + 6 );
+    REQUIRE( std::equal( copy, new_last, simplified_7 ) );
+
+    std::copy( std::begin( points ), std::end( points ), copy );
+    new_last = simplify::simplify2i( copy, copy + 10, 8 );
+    REQUIRE( new_last == copy + 4 );
+    REQUIRE( std::equal( copy, new_last, simplified_8 ) );
+}
+
+#if defined( __SIZEOF_INT128__ )
+
+TEST_CASE( "simplify: drops int points whose exact distance is below the tolerance", "[simplify]" )
+{
+    // The former kernel rounded the projected point to integers and kept all five points.
+
+    int points[] { 0, 0, 1, 1, 2, 0, 3, 1, 4, 0 }, simplified[] { 0, 0, 1, 1, 4, 0 };
+
+    auto new_last = simplify::simplify2i( points, points + 10, 1, true );
+    REQUIRE( new_last == points + 6 );
+    REQUIRE( std::equal( points, new_last, simplified ) );
+}
+
+TEST_CASE( "simplify: simplifies int16_t tile coordinates in place like int ones (2D)", "[simplify]" )
+{
+    std::vector< std::int16_t > points;
+
+    for ( int i = 0; i < 1500; ++i )
+    {
+        points.push_back( std::int16_t( ( i * 977 ) % 65536 - 32768 ) );
+        points.push_back( std::int16_t( std::sin( i * 0.02 ) * 32767.0 ) );
+    }
+
+    for ( std::int16_t tolerance : { std::int16_t( 0 ), std::int16_t( 3 ), std::int16_t( 700 ), std::int16_t( 32767 ) } )
+    {
+        for ( bool highest_quality : { false, true } )
+        {
+            std::vector< std::int16_t > tile = points;
+            std::vector< int > widened( points.begin(), points.end() );
+
+            auto tile_last = simplify::simplify2s( tile.data(), tile.data() + tile.size(), tolerance, highest_quality );
+            auto widened_last = simplify::simplify2i( widened.data(), widened.data() + widened.size(), tolerance, highest_quality );
+            REQUIRE( tile_last - tile.data() == widened_last - widened.data() );
+            REQUIRE( std::equal( tile.data(), tile_last, widened.data() ) );
+        }
+    }
+}
+
+#endif
+
+TEST_CASE( "simplify: the float-native kernel matches the promoted one away from ties (2D)", "[simplify]" )
+{
+    std::vector< float > points;
+
+    for ( int i = 0; i < 2000; ++i )
+    {
+        points.push_back( i * 0.25f );
+        points.push_back( std::sin( i * 0.05f ) * 10.0f + ( i % 7 ) * 0.3f );
+    }
+
+    for ( bool highest_quality : { false, true } )
+    {
+        std::vector< float > native = points, promoted = points;
+
+        auto native_last = simplify::helpers::simplify< float, 2 >( native.data(), native.data() + native.size(), 0.75f, highest_quality );
+        auto promoted_last = simplify::helpers::simplify< float, 2, simplify::helpers::promoted_distance_kernel< float, 2 > >( promoted.data(), promoted.data() + promoted.size(), 0.75f, highest_quality );
+        REQUIRE( native_last - native.data() == promoted_last - promoted.data() );
+        REQUIRE( std::equal( native.data(), native_last, promoted.data() ) );
+    }
+}
+
+TEST_CASE( "simplify: a precision policy separates storage and accumulation types (2D)", "[simplify]" )
+{
+    std::vector< float > points;
+
+    for ( int i = 0; i < 2000; ++i )
+    {
+        points.push_back( 4000000.0f + i * 0.5f );
+        points.push_back( -3000000.0f + std::sin( i * 0.05f ) * 8.0f + ( i % 5 ) * 0.25f );
+    }
+
+    for ( bool highest_quality : { false, true } )
+    {
+        std::vector< float > accumulated = points;
+        std::vector< double > reference( points.begin(), points.end() );
+
+        auto accumulated_last = simplify::helpers::simplify< float, 2, simplify::helpers::precision_kernel< float, 2, double > >( accumulated.data(), accumulated.data() + accumulated.size(), 0.75f, highest_quality );
+        auto reference_last = simplify::helpers::simplify< double, 2, simplify::helpers::native_distance_kernel< double, 2 > >( reference.data(), reference.data() + reference.size(), 0.75, highest_quality );
+        REQUIRE( accumulated_last - accumulated.data() == reference_last - reference.data() );
+        REQUIRE( std::equal( accumulated.data(), accumulated_last, reference.data() ) );
+
+        std::vector< float > native = points, same_precision = points;
+
+        auto native_last = simplify::simplify2f( native.data(), native.data() + native.size(), 0.75f, highest_quality );
+        auto same_precision_last = simplify::helpers::simplify< float, 2, simplify::helpers::precision_kernel< float, 2, float > >( same_precision.data(), same_precision.data() + same_precision.size(), 0.75f, highest_quality );
+        REQUIRE( native_last - native.data() == same_precision_last - same_precision.data() );
+        REQUIRE( std::equal( native.data(), native_last, same_precision.data() ) );
+    }
+}
+
+TEST_CASE( "simplify: a narrowing precision policy keeps the detail of far away coordinates (2D)", "[simplify]" )
+{
+    std::vector< double > offset_points, points;
+
+    for ( int i = 0; i < 2000; ++i )
+    {
+        const double x = i * 0.5, y = std::sin( i * 0.05 ) * 8.0 + ( i % 5 ) * 0.25;
+
+        offset_points.push_back( 40000000.0 + x );
+        offset_points.push_back( -30000000.0 + y );
+        points.push_back( offset_points[ 2 * i ] - 40000000.0 );
+        points.push_back( offset_points[ 2 * i + 1 ] + 30000000.0 );
+    }
+
+    for ( bool highest_quality : { false, true } )
+    {
+        std::vector< double > narrowed = offset_points, reference = points;
+
+        auto narrowed_last = simplify::helpers::simplify< double, 2, simplify::helpers::precision_kernel< double, 2, float > >( narrowed.data(), narrowed.data() + narrowed.size(), 0.75, highest_quality );
+        auto reference_last = simplify::simplify2d( reference.data(), reference.data() + reference.size(), 0.75, highest_quality );
+        REQUIRE( narrowed_last - narrowed.data() == reference_last - reference.data() );
+
+        for ( auto it = narrowed.data(), reference_it = reference.data(); it != narrowed_last; it += 2, reference_it += 2 )
+        {
+            REQUIRE( it[ 0 ] - 40000000.0 == reference_it[ 0 ] );
+            REQUIRE( it[ 1 ] + 30000000.0 == reference_it[ 1 ] );
+        }
+    }
+}
+
+#if defined( __cpp_constexpr ) && __cpp_constexpr >= 201304
+
+namespace
+{
+    using vec2d = simplify::helpers::vect< double, 2 >;
+
+    struct outline
+    {
+        vec2d points[ 8 ];
+        std::size_t point_count;
+    };
+
+    constexpr outline get_simplified_outline( const double tolerance, const bool highest_quality )
+    {
+        outline result { { { { 0.0, 0.0 } }, { { 0.5, 0.1 } }, { { 2.0, 0.2 } }, { { 3.0, 3.0 } }, { { 3.1, 3.2 } }, { { 5.0, 3.1 } }, { { 7.0, 0.0 } }, { { 8.0, 0.0 } } }, 8 };
+        simplify::fixed_douglas_peucker_scratch< vec2d *, 8 > scratch;
+
+        result.point_count = simplify::helpers::simplify( result.points, result.points + 8, tolerance, highest_quality, scratch ) - result.points;
+
+        return result;
+    }
+}
+
+TEST_CASE( "simplify: simplifies vect storage in constant expressions like at run time (2D)", "[simplify]" )
+{
+    constexpr outline simplified = get_simplified_outline( 1.0, false ), highest_quality_simplified = get_simplified_outline( 1.0, true );
+
+    static_assert( simplified.point_count == 3, "simplified at compile time" );
+    static_assert( highest_quality_simplified.point_count == 4, "simplified at compile time" );
+
+    for ( bool highest_quality : { false, true } )
+    {
+        const outline & expected = highest_quality ? highest_quality_simplified : simplified;
+        outline points = get_simplified_outline( 0.0, false );
+
+        REQUIRE( points.point_count == 8 );
+
+        auto new_last = simplify::simplify2d( &points.points[ 0 ].values[ 0 ], &points.points[ 0 ].values[ 0 ] + 16, 1.0, highest_quality );
+        REQUIRE( new_last - &points.points[ 0 ].values[ 0 ] == static_cast< std::ptrdiff_t >( expected.point_count * 2 ) );
+        REQUIRE( std::equal( points.points, points.points + expected.point_count, expected.points ) );
+    }
+}
+
+#endif
+
+TEST_CASE( "simplify_strided: compacts whole interleaved vertices like simplify does positions (2D)", "[simplify]" )
+{
+    struct vertex
+    {
+        float position[ 2 ];
+        float normal[ 3 ];
+        std::uint32_t colour;
+    };
+
+    std::vector< vertex > vertices;
+    std::vector< float > positions;
+
+    for ( int i = 0; i < 500; ++i )
+    {
+        const vertex current { { i * 0.5f, std::sin( i * 0.1f ) * 4.0f }, { 0.0f, 0.0f, 1.0f }, std::uint32_t( i ) };
+
+        vertices.push_back( current );
+        positions.push_back( current.position[ 0 ] );
+        positions.push_back( current.position[ 1 ] );
+    }
+
+    for ( bool highest_quality : { false, true } )
+    {
+        std::vector< vertex > simplified_vertices = vertices;
+        std::vector< float > simplified_positions = positions;
+
+        auto kept_count = simplify::helpers::simplify_strided< float, 2 >( simplified_vertices.data(), simplified_vertices.size(), sizeof( vertex ), 0.5f, highest_quality );
+        auto new_last = simplify::simplify2f( simplified_positions.data(), simplified_positions.data() + simplified_positions.size(), 0.5f, highest_quality );
+        REQUIRE( kept_count * 2 == static_cast< std::size_t >( new_last - simplified_positions.data() ) );
+        REQUIRE( kept_count < vertices.size() );
+
+        for ( std::size_t i = 0; i < kept_count; ++i )
+        {
+            const vertex & original = vertices[ simplified_vertices[ i ].colour ];
+
+            REQUIRE( simplified_vertices[ i ].position[ 0 ] == simplified_positions[ 2 * i ] );
+            REQUIRE( simplified_vertices[ i ].position[ 1 ] == simplified_positions[ 2 * i + 1 ] );
+            REQUIRE( std::equal( original.position, original.position + 2, simplified_vertices[ i ].position ) );
+        }
+    }
+}
+
+TEST_CASE( "simplify_strided: rejects a stride smaller than a position (3D)", "[simplify]" )
+{
+    float coordinates[] { 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 2.0f, 0.0f, 0.0f },
+        original[] { 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 2.0f, 0.0f, 0.0f };
+
+    auto kept_count = simplify::helpers::simplify_strided< float, 3 >( coordinates, 3, 2 * sizeof( float ), 10.0f );
+    REQUIRE( kept_count == 0 );
+    REQUIRE( std::equal( std::begin( coordinates ), std::end( coordinates ), original ) );
+
+    kept_count = simplify::helpers::simplify_strided< float, 3 >( coordinates, 3, 3 * sizeof( float ), 10.0f );
+    REQUIRE( kept_count == 2 );
+}
+
+TEST_CASE( "simplify_lon_lat: measures the tolerance in metres on lon/lat degrees", "[simplify]" )
+{
+    // A 1 km track heading north with points every 250 m, its middle point being 2 m to the east. A
+    // degree of longitude is pi / 180 times the radius of the parallel on the WGS 84 ellipsoid.
+
+    const double latitude = 48.85, longitude = 2.35, radian_per_degree = 3.14159265358979323846 / 180.0;
+    const double prime_vertical_radius = 6378137.0 / std::sqrt( 1.0 - 0.00669437999014 * std::pow( std::sin( latitude * radian_per_degree ), 2 ) );
+    const double degree_per_east_metre = 1.0 / ( radian_per_degree * prime_vertical_radius * std::cos( latitude * radian_per_degree ) );
+    std::vector< double > points;
+
+    for ( int i = 0; i <= 4; ++i )
+    {
+        points.push_back( longitude + ( i == 2 ? 2.0 * degree_per_east_metre : 0.0 ) );
+        points.push_back( latitude + i * 250.0 / 111200.0 );
+    }
+
+    for ( bool use_earth_centered : { false, true } )
+    {
+        for ( bool highest_quality : { false, true } )
+        {
+            std::vector< double > copy = points;
+
+            auto new_last = simplify::helpers::simplify_lon_lat( copy.data(), copy.data() + copy.size(), 1.9, highest_quality, use_earth_centered );
+            REQUIRE( new_last == copy.data() + 6 );
+            REQUIRE( copy[ 2 ] == points[ 4 ] );
+            REQUIRE( copy[ 3 ] == points[ 5 ] );
+
+            copy = points;
+            new_last = simplify::helpers::simplify_lon_lat( copy.data(), copy.data() + copy.size(), 2.1, highest_quality, use_earth_centered );
+            REQUIRE( new_last == copy.data() + 4 );
+            REQUIRE( copy[ 2 ] == points[ 8 ] );
+            REQUIRE( copy[ 3 ] == points[ 9 ] );
+        }
+    }
+}
+
+TEST_CASE( "get_max_deviation: measures each dropped point against the output segment that replaced it (2D)", "[simplify]" )
+{
+    using vec2d = simplify::helpers::vect< double, 2 >;
+
+    const vec2d points[] { { { 0.0, 0.0 } }, { { 1.0, 0.5 } }, { { 2.0, -0.25 } }, { { 3.0, 3.0 } }, { { 4.0, 0.0 } } },
+        output[] { points[ 0 ], points[ 3 ], points[ 4 ] };
+    const std::size_t kept_indices[] { 0, 3, 4 };
+
+    auto deviation = simplify::helpers::get_max_deviation( points, kept_indices, kept_indices + 3 );
+    REQUIRE( deviation.square_distance == Approx( 2.53125 ) );
+    REQUIRE( deviation.index == 2 );
+
+    deviation = simplify::helpers::get_max_deviation( points, points + 5, output, output + 3 );
+    REQUIRE( deviation.square_distance == Approx( 2.53125 ) );
+    REQUIRE( deviation.index == 2 );
+
+    deviation = simplify::helpers::get_max_deviation( points, points + 5, points, points + 5 );
+    REQUIRE( deviation.square_distance == 0.0 );
+
+    const vec2d unmatched_output[] { points[ 0 ], { { 3.0, 2.0 } }, points[ 4 ] };
+
+    deviation = simplify::helpers::get_max_deviation( points, points + 5, unmatched_output, unmatched_output + 3 );
+    REQUIRE( std::isinf( deviation.square_distance ) );
+    REQUIRE( deviation.index == 5 );
+
+    std::vector< vec2d > walk { vec2d { { 0.0, 0.0 } } };
+
+    for ( int i = 1; i < 5000; ++i )
+    {
+        walk.push_back( vec2d { { walk.back().values[ 0 ] + std::cos( i * 0.37 ), walk.back().values[ 1 ] + std::sin( i * 0.011 ) } } );
+    }
+
+    std::vector< vec2d > simplified = walk;
+    auto simplified_last = reinterpret_cast< vec2d * >( simplify::helpers::simplify< double, 2 >( simplified.front().values, simplified.back().values + 2, 2.0, true ) );
+    REQUIRE( simplified_last - simplified.data() < 1000 );
+
+    deviation = simplify::helpers::get_max_deviation( walk.data(), walk.data() + walk.size(), simplified.data(), simplified_last );
+    REQUIRE( deviation.square_distance > 1.0 );
+    REQUIRE( deviation.square_distance <= 4.0 * ( 1.0 + 1e-12 ) );
+}
+
 TEST_CASE( "simplify: just returns the points if it has only one point", "[simplify]" )
 {
     int single_point[] { 1, 2 };
@@ -303,3 +1017,176 @@ TEST_CASE( "simplify: just returns the points if it has no points", "[simplify]"
     auto new_last = simplify::simplify2i( empty, empty );
     REQUIRE( new_last == empty );
 }
+
+TEST_CASE( "simplify_levels: keeps the ends at every level and drops aligned points at the coarse ones", "[simplify]" )
+{
+    double points[] { 0.0, 0.0, 1.0, 0.5, 2.0, 0.0, 3.0, 3.0, 4.0, 0.0 },
+        tolerances[] { 2.0, 0.25 };
+    unsigned char levels[ 5 ],
+        expected_levels[] { 0, 1, 1, 0, 0 };
+
+    auto levels_last = simplify::helpers::simplify_levels< double, 2 >( points, points + 10, tolerances, 2, levels );
+    REQUIRE( levels_last == levels + 5 );
+    REQUIRE( std::equal( levels, levels + 5, expected_levels ) );
+}
+
+// simplify_batch
+
+TEST_CASE( "simplify_batch: matches simplify on each feature, in place and into a separate output", "[simplify_batch]" )
+{
+    std::vector< float > coordinates;
+    std::vector< std::size_t > offsets { 0 };
+
+    for ( std::size_t feature = 0; feature < 300; ++feature )
+    {
+        const std::size_t point_count = feature % 7 == 0 ? feature % 3 : 20 + feature % 50;
+
+        for ( std::size_t point = 0; point < point_count; ++point )
+        {
+            coordinates.push_back( float( point ) );
+            coordinates.push_back( float( ( point * 7 + feature ) % 11 ) );
+        }
+
+        offsets.push_back( offsets.back() + point_count );
+    }
+
+    std::vector< float > expected;
+    std::vector< std::size_t > expected_offsets { 0 };
+
+    for ( std::size_t feature = 0; feature + 1 < offsets.size(); ++feature )
+    {
+        std::vector< float > points( coordinates.begin() + offsets[ feature ] * 2, coordinates.begin() + offsets[ feature + 1 ] * 2 );
+        auto new_last = simplify::simplify2f( points.data(), points.data() + points.size(), 2.0f );
+
+        expected.insert( expected.end(), points.data(), new_last );
+        expected_offsets.push_back( expected.size() / 2 );
+    }
+
+    std::vector< float > output( coordinates.size() );
+    std::vector< std::size_t > new_offsets( offsets.size() );
+
+    auto new_last = simplify::helpers::simplify_batch< float, 2 >( coordinates.data(), offsets.data(), offsets.size() - 1, new_offsets.data(), output.data(), 2.0f, false, 4 );
+    REQUIRE( new_offsets == expected_offsets );
+    REQUIRE( std::size_t( new_last - output.data() ) == expected.size() );
+    REQUIRE( std::equal( expected.begin(), expected.end(), output.data() ) );
+
+    new_last = simplify::helpers::simplify_batch< float, 2 >( coordinates.data(), offsets.data(), offsets.size() - 1, offsets.data(), coordinates.data(), 2.0f, false, 3 );
+    REQUIRE( offsets == expected_offsets );
+    REQUIRE( std::size_t( new_last - coordinates.data() ) == expected.size() );
+    REQUIRE( std::equal( expected.begin(), expected.end(), coordinates.data() ) );
+}
+
+TEST_CASE( "simplify_batch: uses the tolerance of each feature", "[simplify_batch]" )
+{
+    int coordinates[] { 0, 0, 1, 2, 2, 0, 3, 2, 4, 0,   0, 0, 1, 2, 2, 0, 3, 2, 4, 0 },
+        simplified[] { 0, 0, 1, 2, 2, 0, 3, 2, 4, 0,   0, 0, 4, 0 },
+        tolerances[] { 1, 3 };
+    std::size_t offsets[] { 0, 5, 10 },
+        simplified_offsets[] { 0, 5, 7 };
+
+    auto new_last = simplify::helpers::simplify_batch< int, 2 >( coordinates, offsets, 2, offsets, coordinates, tolerances, true );
+    REQUIRE( std::equal( offsets, offsets + 3, simplified_offsets ) );
+    REQUIRE( new_last == coordinates + 14 );
+    REQUIRE( std::equal( coordinates, new_last, simplified ) );
+}
+
+// simplify_coverage
+
+TEST_CASE( "simplify_coverage: simplifies a shared edge the same way in both rings", "[simplify_coverage]" )
+{
+    std::vector< double > coordinates;
+    std::vector< std::size_t > offsets { 0 };
+
+    auto add_point = [ & ]( double x, double y ) { coordinates.push_back( x ); coordinates.push_back( y ); };
+    auto shared_x = []( int y ) { return 10.0 + ( y % 3 ) * 0.4 - ( y == 5 ? 3.0 : 0.0 ); };
+
+    add_point( 0.0, 0.0 );
+    add_point( 10.0, 0.0 );
+    for ( int y = 1; y < 10; ++y ) add_point( shared_x( y ), double( y ) );
+    add_point( 10.0, 10.0 );
+    add_point( 0.0, 10.0 );
+    add_point( 0.0, 0.0 );
+    offsets.push_back( coordinates.size() / 2 );
+
+    add_point( 10.0, 0.0 );
+    add_point( 20.0, 0.0 );
+    add_point( 20.0, 10.0 );
+    add_point( 10.0, 10.0 );
+    for ( int y = 9; y > 0; --y ) add_point( shared_x( y ), double( y ) );
+    add_point( 10.0, 0.0 );
+    offsets.push_back( coordinates.size() / 2 );
+
+    add_point( 30.0, 0.0 );
+    add_point( 31.0, 0.0 );
+    add_point( 30.0, 0.0 );
+    offsets.push_back( coordinates.size() / 2 );
+
+    std::vector< double > output( coordinates.size() );
+    std::vector< std::size_t > new_offsets( offsets.size() );
+
+    auto new_last = simplify::helpers::simplify_coverage< double, 2 >( coordinates.data(), offsets.data(), 3, new_offsets.data(), output.data(), 1.0, true, 2 );
+    REQUIRE( new_last == output.data() + new_offsets.back() * 2 );
+
+    auto get_shared_points = [ & ]( std::size_t ring )
+    {
+        std::vector< std::pair< double, double > > shared_points;
+
+        for ( std::size_t point = new_offsets[ ring ]; point < new_offsets[ ring + 1 ]; ++point )
+        {
+            if ( output[ point * 2 ] > 5.0 && output[ point * 2 ] < 15.0 )
+            {
+                shared_points.push_back( std::make_pair( output[ point * 2 ], output[ point * 2 + 1 ] ) );
+            }
+        }
+
+        std::sort( shared_points.begin(), shared_points.end() );
+        shared_points.erase( std::unique( shared_points.begin(), shared_points.end() ), shared_points.end() );
+
+        return shared_points;
+    };
+
+    const std::vector< std::pair< double, double > > expected_shared_points { { shared_x( 5 ), 5.0 }, { 10.0, 0.0 }, { 10.0, 6.0 }, { 10.0, 10.0 }, { shared_x( 4 ), 4.0 } };
+    REQUIRE( get_shared_points( 0 ) == expected_shared_points );
+    REQUIRE( get_shared_points( 1 ) == expected_shared_points );
+    REQUIRE( new_offsets[ 3 ] - new_offsets[ 2 ] == 3 );
+
+    for ( std::size_t ring = 0; ring < 3; ++ring )
+    {
+        REQUIRE( output[ new_offsets[ ring ] * 2 ] == output[ ( new_offsets[ ring + 1 ] - 1 ) * 2 ] );
+        REQUIRE( output[ new_offsets[ ring ] * 2 + 1 ] == output[ ( new_offsets[ ring + 1 ] - 1 ) * 2 + 1 ] );
+    }
+
+    new_last = simplify::helpers::simplify_coverage< double, 2 >( coordinates.data(), offsets.data(), 3, offsets.data(), coordinates.data(), 1.0, true, 2 );
+    REQUIRE( offsets == new_offsets );
+    REQUIRE( std::equal( coordinates.data(), new_last, output.begin() ) );
+}
+
+TEST_CASE( "simplify_coverage: keeps whole the arcs of rings that would collapse", "[simplify_coverage]" )
+{
+    // The first ring has no junction, so its single arc starts and ends on ( 0, 0 ) and would be
+    // simplified down to these two points. The next two squares share an edge, and each of their
+    // two arcs would be simplified down to its ends, leaving three points per ring.
+
+    double coordinates[] {
+            0.0, 0.0, 1.0, 0.0, 1.0, 1.0, 0.0, 1.0, 0.0, 0.0,
+            10.0, 0.0, 11.0, 0.0, 11.0, 1.0, 10.0, 1.0, 10.0, 0.0,
+            11.0, 0.0, 12.0, 0.0, 12.0, 1.0, 11.0, 1.0, 11.0, 0.0
+        },
+        output[ 30 ];
+    std::size_t offsets[] { 0, 5, 10, 15 }, new_offsets[ 4 ];
+
+    for ( bool highest_quality : { false, true } )
+    {
+        auto new_last = simplify::helpers::simplify_coverage< double, 2 >( coordinates, offsets, 3, new_offsets, output, 100.0, highest_quality, 1 );
+        REQUIRE( new_last == output + 30 );
+
+        for ( std::size_t ring = 0; ring < 3; ++ring )
+        {
+            REQUIRE( new_offsets[ ring + 1 ] - new_offsets[ ring ] == 5 );
+            REQUIRE( output[ new_offsets[ ring ] * 2 ] == output[ ( new_offsets[ ring + 1 ] - 1 ) * 2 ] );
+            REQUIRE( output[ new_offsets[ ring ] * 2 + 1 ] == output[ ( new_offsets[ ring + 1 ] - 1 ) * 2 + 1 ] );
+        }
+
+        REQUIRE( std::equal( output, output + 10, coordinates ) );
+    }
+}